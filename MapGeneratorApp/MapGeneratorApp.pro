@@ -36,16 +36,29 @@ INCLUDEPATH += \
         ../GSL/include/
 
 SOURCES += \
+        ../gameinfocache.cpp \
+        ../mappedfile.cpp \
+        ../ScenarioGenerator/src/availabilityindex.cpp \
+        ../ScenarioGenerator/src/batchgenerator.cpp \
         ../ScenarioGenerator/src/blueprint.cpp \
+        ../ScenarioGenerator/src/bytesink.cpp \
         ../ScenarioGenerator/src/currency.cpp \
         ../ScenarioGenerator/src/decoration.cpp \
+        ../ScenarioGenerator/src/distancefield.cpp \
         ../ScenarioGenerator/src/gameinfo.cpp \
         ../ScenarioGenerator/src/generatorsettings.cpp \
         ../ScenarioGenerator/src/image.cpp \
+        ../ScenarioGenerator/src/itemcatalog.cpp \
         ../ScenarioGenerator/src/itempicker.cpp \
         ../ScenarioGenerator/src/landmarkpicker.cpp \
+        ../ScenarioGenerator/src/luaarena.cpp \
+        ../ScenarioGenerator/src/luastatepool.cpp \
+        ../ScenarioGenerator/src/luatablereader.cpp \
         ../ScenarioGenerator/src/mapgenerator.cpp \
         ../ScenarioGenerator/src/maptemplatereader.cpp \
+        ../ScenarioGenerator/src/pathfinder.cpp \
+        ../ScenarioGenerator/src/privatefiles.cpp \
+        ../ScenarioGenerator/src/profiler.cpp \
         ../ScenarioGenerator/src/rsgid.cpp \
         ../ScenarioGenerator/src/mqdb.cpp \
         ../ScenarioGenerator/src/scenario/bag.cpp \
@@ -130,23 +143,37 @@ SOURCES += \
         mapgeneratorthread.cpp
 
 HEADERS += \
+        ../gameinfocache.h \
+        ../mappedfile.h \
         ../ScenarioGenerator/src/aipriority.h \
+        ../ScenarioGenerator/src/availabilityindex.h \
+        ../ScenarioGenerator/src/batchgenerator.h \
         ../ScenarioGenerator/src/blueprint.h \
+        ../ScenarioGenerator/src/bytesink.h \
         ../ScenarioGenerator/src/containers.h \
         ../ScenarioGenerator/src/currency.h \
         ../ScenarioGenerator/src/decoration.h \
+        ../ScenarioGenerator/src/distancefield.h \
         ../ScenarioGenerator/src/enums.h \
         ../ScenarioGenerator/src/exceptions.h \
         ../ScenarioGenerator/src/gameinfo.h \
         ../ScenarioGenerator/src/generatorsettings.h \
         ../ScenarioGenerator/src/image.h \
+        ../ScenarioGenerator/src/itemcatalog.h \
         ../ScenarioGenerator/src/iteminfo.h \
         ../ScenarioGenerator/src/itempicker.h \
         ../ScenarioGenerator/src/landmarkinfo.h \
         ../ScenarioGenerator/src/landmarkpicker.h \
+        ../ScenarioGenerator/src/luaarena.h \
+        ../ScenarioGenerator/src/luastatepool.h \
+        ../ScenarioGenerator/src/luatablereader.h \
         ../ScenarioGenerator/src/mapgenerator.h \
         ../ScenarioGenerator/src/maptemplate.h \
         ../ScenarioGenerator/src/maptemplatereader.h \
+        ../ScenarioGenerator/src/parallel.h \
+        ../ScenarioGenerator/src/pathfinder.h \
+        ../ScenarioGenerator/src/privatefiles.h \
+        ../ScenarioGenerator/src/profiler.h \
         ../ScenarioGenerator/src/rsgid.h \
         ../ScenarioGenerator/src/mqdb.h \
         ../ScenarioGenerator/src/picker.h \
@@ -200,6 +227,7 @@ HEADERS += \
         ../ScenarioGenerator/src/textconvert.h \
         ../ScenarioGenerator/src/texts.h \
         ../ScenarioGenerator/src/tileinfo.h \
+        ../ScenarioGenerator/src/tileset.h \
         ../ScenarioGenerator/src/unitinfo.h \
         ../ScenarioGenerator/src/unitpicker.h \
         ../ScenarioGenerator/src/vposition.h \
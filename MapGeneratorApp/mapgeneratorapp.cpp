@@ -1,5 +1,6 @@
 #include "mapgeneratorapp.h"
 #include "ui_mapgeneratorapp.h"
+#include "batchgenerator.h"
 #include "gameinfo.h"
 #include "maptemplatereader.h"
 #include "mapgenerator.h"
@@ -77,7 +78,12 @@ MapGeneratorApp::MapGeneratorApp(QWidget *parent) :
 
     disableButtons();
 
-    rsg::bindLuaApi(lua);
+    // Templates are executed for each generation attempt, keep them compiled if user asked to.
+    // Folder is made private to the user, see setTemplateCacheFolder()
+    const QString cacheFolder{qEnvironmentVariable("D2RSG_TEMPLATE_CACHE")};
+    if (!cacheFolder.isEmpty()) {
+        rsg::setTemplateCacheFolder(cacheFolder.toStdString());
+    }
 }
 
 MapGeneratorApp::~MapGeneratorApp()
@@ -85,8 +91,10 @@ MapGeneratorApp::~MapGeneratorApp()
     delete ui;
 }
 
-void MapGeneratorApp::onScenarioMapGenerated(rsg::Map *scenarioMap, const QString &error)
+void MapGeneratorApp::onScenarioMapGenerated(rsg::GeneratedScenario *generated, const QString &error)
 {
+    std::unique_ptr<rsg::GeneratedScenario> result{generated};
+
     // Enable buttons
     enableButtons();
 
@@ -95,7 +103,12 @@ void MapGeneratorApp::onScenarioMapGenerated(rsg::Map *scenarioMap, const QStrin
         return;
     }
 
-    scenario.reset(scenarioMap);
+    // Keep generator for preview images, replace it before template it refers to
+    generator = std::move(result->generator);
+    generatorTemplate = std::move(result->mapTemplate);
+    options = generator->mapGenOptions;
+
+    scenario = std::move(result->map);
     // Allow to save generated scenario
     ui->saveScenarioButtom->setEnabled(true);
     // Update zone and contents images
@@ -202,10 +215,13 @@ void MapGeneratorApp::readTemplateAndUpdateUi(const std::filesystem::path& templ
 {
     try {
         MapTemplatePtr tmplt = std::make_unique<rsg::MapTemplate>();
+        // Executed template state stays in the pool for generation
+        auto pool = std::make_unique<rsg::LuaStatePool>(templatePath);
 
-        tmplt->settings = rsg::readTemplateSettings(templatePath, lua);
+        tmplt->settings = pool->acquire().getSettings();
 
         mapTemplate = std::move(tmplt);
+        templates = std::move(pool);
         templateFilePath = templatePath;
     }
     catch (const std::runtime_error& e) {
@@ -622,46 +638,17 @@ void MapGeneratorApp::on_generateButton_clicked()
     using namespace rsg;
 
     const auto seed = getScenarioSeed();
-    const auto seedString = std::to_string(seed);
 
     auto& settings = mapTemplate->settings;
     settings.size = scenarioSize;
     getSelectedRaces(settings.races, settings.maxPlayers);
 
-    // Create options
-    options = MapGenOptions();
-    options.mapTemplate = mapTemplate.get();
-    options.name = std::string{"Random scenario "} + seedString;
-    options.description = std::string{"Random scenario based on template '"}
-            + settings.name
-            + std::string{"'. Seed: "} + seedString
-            + ". Starting gold: " + std::to_string(settings.startingGold)
-            + ". Roads: " + std::to_string(settings.roads)
-            + "%. Forest: " + std::to_string(settings.forest)
-            + "%.";
-    options.size = settings.size;
-    // Create generator
-    generator = std::make_unique<rsg::MapGenerator>(options, seed);
-
-    try {
-        // Cleanup previous contents, if any
-        mapTemplate->contents = MapTemplateContents();
-
-        settings.replaceRandomRaces(generator->randomGenerator);
-        // Generate new contents according to user settings
-        readTemplateContents(*mapTemplate, lua);
-    }
-    catch (const std::exception& e)
-    {
-        QMessageBox::critical(this, tr("Error"), tr("Could not generate template contents. Reason: %1").arg(e.what()));
-    }
-
     // Remember radio button states
     rememberRadioButtonStates();
     // Disable buttons
     disableButtons(true);
     // Start generation in another thread, wait for signal
-    auto thread = new MapGeneratorThread(generator.get(), this);
+    auto thread = new MapGeneratorThread(templates.get(), settings, seed, this);
 
     connect(thread, &MapGeneratorThread::mapGenerated, this, &MapGeneratorApp::onScenarioMapGenerated);
     connect(thread, &QThread::finished, thread, &QObject::deleteLater);
@@ -1,6 +1,8 @@
 #ifndef MAPGENERATORAPP_H
 #define MAPGENERATORAPP_H
 
+#include "batchgenerator.h"
+#include "luastatepool.h"
 #include "maptemplate.h"
 #include "mapgenerator.h"
 #include "standalonegameinfo.h"
@@ -8,7 +10,6 @@
 #include <memory>
 #include <QWidget>
 #include <QTimer>
-#include <sol/sol.hpp>
 
 namespace Ui {
 class MapGeneratorApp;
@@ -23,7 +24,7 @@ public:
     ~MapGeneratorApp();
 
 public slots:
-    void onScenarioMapGenerated(rsg::Map* scenarioMap, const QString& error);
+    void onScenarioMapGenerated(rsg::GeneratedScenario* generated, const QString& error);
     void seedPlaceholderUpdate();
     void onRaceSelected(int comboBoxIndex);
 
@@ -72,7 +73,6 @@ private:
     void updatePreviewImages();
     void getSelectedRaces(std::vector<rsg::RaceType>& races, int maxPlayers);
 
-    sol::state lua;
     Ui::MapGeneratorApp *ui;
 
     QTimer seedPlaceholderTimer;
@@ -80,6 +80,10 @@ private:
 
     using MapTemplatePtr = std::unique_ptr<rsg::MapTemplate>;
     MapTemplatePtr mapTemplate;
+    // Lua states with executed template
+    std::unique_ptr<rsg::LuaStatePool> templates;
+    // Template of generated scenario, generator refers to it
+    MapTemplatePtr generatorTemplate;
     rsg::MapGenOptions options;
 
     using MapGeneratorPtr = std::unique_ptr<rsg::MapGenerator>;
@@ -1,21 +1,29 @@
 #include "mapgeneratorthread.h"
-#include "mapgenerator.h"
+#include "batchgenerator.h"
 #include "map.h"
+#include <memory>
 #include <stdexcept>
 
 void MapGeneratorThread::run()
 {
     try {
-        auto scenarioMap = generator->generate();
-        emit mapGenerated(scenarioMap.release(), "");
+        // Retry with other seeds if zones lack space, result is the same for the same seed
+        auto generated = std::make_unique<rsg::GeneratedScenario>(
+            rsg::generateWithRetries(*templates, settings, seed));
+        emit mapGenerated(generated.release(), "");
     } catch (const std::exception& e) {
         auto error = QString{"Exception during map generation: "} + e.what();
         emit mapGenerated(nullptr, error);
     }
 }
 
-MapGeneratorThread::MapGeneratorThread(rsg::MapGenerator *generator, QObject *parent)
+MapGeneratorThread::MapGeneratorThread(rsg::LuaStatePool* templates,
+                                       const rsg::MapTemplateSettings& settings,
+                                       std::time_t seed,
+                                       QObject *parent)
     : QThread(parent)
-    , generator{generator}
+    , templates{templates}
+    , settings{settings}
+    , seed{seed}
 {
 }
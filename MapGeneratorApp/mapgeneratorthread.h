@@ -1,12 +1,14 @@
 #ifndef MAPGENERATORWORKER_H
 #define MAPGENERATORWORKER_H
 
+#include "maptemplate.h"
 #include <QThread>
+#include <ctime>
 #include <string>
 
 namespace rsg {
-class MapGenerator;
-class Map;
+struct GeneratedScenario;
+class LuaStatePool;
 }
 
 class MapGeneratorThread : public QThread
@@ -16,13 +18,19 @@ class MapGeneratorThread : public QThread
     void run() override;
 
 public:
-    explicit MapGeneratorThread(rsg::MapGenerator* generator, QObject *parent = nullptr);
+    explicit MapGeneratorThread(rsg::LuaStatePool* templates,
+                                const rsg::MapTemplateSettings& settings,
+                                std::time_t seed,
+                                QObject *parent = nullptr);
 
 signals:
-    void mapGenerated(rsg::Map* scenarioMap, const QString& error);
+    // Receiver takes ownership of generated scenario
+    void mapGenerated(rsg::GeneratedScenario* generated, const QString& error);
 
 private:
-    rsg::MapGenerator* generator;
+    rsg::LuaStatePool* templates;
+    rsg::MapTemplateSettings settings;
+    std::time_t seed;
 };
 
 #endif // MAPGENERATORWORKER_H
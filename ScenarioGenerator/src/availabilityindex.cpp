@@ -0,0 +1,99 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "availabilityindex.h"
+#include "mapgenerator.h"
+#include "tileset.h"
+#include <algorithm>
+#include <limits>
+
+namespace rsg {
+
+bool AvailabilityIndex::isAreaAvailable(TemplateZoneId id,
+                                        const TileSet& zoneTiles,
+                                        const Position& position,
+                                        const Position& size)
+{
+    if (!built || zoneId != id || tilesVersion != mapGenerator->getTilesVersion()) {
+        rebuild(id, zoneTiles);
+    }
+
+    // Rectangle relative to zone bounding box
+    const int startX{position.x - origin.x};
+    const int startY{position.y - origin.y};
+    const int endX{startX + size.x};
+    const int endY{startY + size.y};
+
+    // Tiles outside of bounding box are either outside of the map or belong to other zones
+    if (startX < 0 || startY < 0 || endX > width || endY > height) {
+        return false;
+    }
+
+    const int available{getSum(endX, endY) - getSum(startX, endY) - getSum(endX, startY)
+                        + getSum(startX, startY)};
+
+    return available == size.x * size.y;
+}
+
+void AvailabilityIndex::rebuild(TemplateZoneId id, const TileSet& zoneTiles)
+{
+    built = true;
+    zoneId = id;
+    tilesVersion = mapGenerator->getTilesVersion();
+
+    if (zoneTiles.empty()) {
+        origin = Position{};
+        width = height = 0;
+        sums.assign(1, 0);
+        return;
+    }
+
+    Position minimum{std::numeric_limits<int>::max(), std::numeric_limits<int>::max()};
+    Position maximum{-1, -1};
+
+    for (const auto& tile : zoneTiles) {
+        minimum.x = std::min(minimum.x, tile.x);
+        minimum.y = std::min(minimum.y, tile.y);
+        maximum.x = std::max(maximum.x, tile.x);
+        maximum.y = std::max(maximum.y, tile.y);
+    }
+
+    origin = minimum;
+    width = maximum.x - minimum.x + 1;
+    height = maximum.y - minimum.y + 1;
+
+    const int stride{width + 1};
+    sums.assign(static_cast<std::size_t>(stride * (height + 1)), 0);
+
+    for (int y = 0; y < height; ++y) {
+        int rowSum{};
+
+        for (int x = 0; x < width; ++x) {
+            const Position tile{origin.x + x, origin.y + y};
+
+            if (mapGenerator->isPossible(tile) && mapGenerator->getZoneId(tile) == zoneId) {
+                ++rowSum;
+            }
+
+            sums[(x + 1) + stride * (y + 1)] = sums[(x + 1) + stride * y] + rowSum;
+        }
+    }
+}
+
+} // namespace rsg
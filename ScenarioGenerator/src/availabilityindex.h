@@ -0,0 +1,69 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "position.h"
+#include "zoneid.h"
+#include <cstdint>
+#include <vector>
+
+namespace rsg {
+
+class MapGenerator;
+class TileSet;
+
+// Summed-area table of zone tiles available for object placement:
+// possible tiles that belong to the zone.
+// Table covers bounding box of zone tiles and is rebuilt lazily
+// when tiles of the map were changed since the last query.
+class AvailabilityIndex
+{
+public:
+    AvailabilityIndex(MapGenerator* mapGenerator)
+        : mapGenerator{mapGenerator}
+    { }
+
+    // Returns true if all tiles of rectangle with top left corner at 'position'
+    // are possible and belong to zone with specified id and tiles
+    bool isAreaAvailable(TemplateZoneId zoneId,
+                         const TileSet& zoneTiles,
+                         const Position& position,
+                         const Position& size);
+
+private:
+    void rebuild(TemplateZoneId id, const TileSet& zoneTiles);
+
+    // Number of available tiles in rectangle [origin : origin + (x, y)), x and y are exclusive
+    int getSum(int x, int y) const
+    {
+        return sums[x + (width + 1) * y];
+    }
+
+    MapGenerator* mapGenerator{};
+    std::vector<int> sums; // (width + 1) * (height + 1) prefix sums, first row and column are 0
+    Position origin;       // Top left corner of zone bounding box
+    int width{};
+    int height{};
+    TemplateZoneId zoneId{}; // Zone the table was built for
+    std::uint32_t tilesVersion{};
+    bool built{};
+};
+
+} // namespace rsg
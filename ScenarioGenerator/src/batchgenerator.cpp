@@ -0,0 +1,296 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "batchgenerator.h"
+#include "exceptions.h"
+#include "luastatepool.h"
+#include "maptemplatereader.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <sol/sol.hpp>
+#include <sstream>
+#include <thread>
+
+namespace rsg {
+
+// Applies batch options to template settings read from template file
+static void applyBatchOptions(MapTemplateSettings& settings, const BatchOptions& options)
+{
+    settings.size = options.size;
+    settings.races = options.races;
+    // Players not chosen explicitly get random races
+    settings.races.resize(settings.maxPlayers, RaceType::Random);
+}
+
+static void checkBatchOptions(const MapTemplateSettings& settings, const BatchOptions& options)
+{
+    if (options.firstSeed > options.lastSeed) {
+        throw std::runtime_error("First seed of the batch is greater than the last one");
+    }
+
+    if (options.size < settings.sizeMin || options.size > settings.sizeMax) {
+        std::stringstream stream;
+        stream << "Scenario size " << options.size << " is not supported by template '"
+               << settings.name << "', expected size in range [" << settings.sizeMin << " : "
+               << settings.sizeMax << "]";
+        throw TemplateException(stream.str());
+    }
+
+    if (static_cast<int>(options.races.size()) > settings.maxPlayers) {
+        std::stringstream stream;
+        stream << "Too many races specified, template '" << settings.name << "' allows up to "
+               << settings.maxPlayers << " players";
+        throw TemplateException(stream.str());
+    }
+}
+
+MapGenOptions createMapGenOptions(const MapTemplate& mapTemplate,
+                                  std::time_t seed,
+                                  RandomEngine engine)
+{
+    const MapTemplateSettings& settings{mapTemplate.settings};
+    const std::string seedString{std::to_string(seed)};
+
+    MapGenOptions options;
+    options.mapTemplate = &mapTemplate;
+
+    // MapTemplateSettings name and description are used for ingame (or standalone tool) UI only.
+    options.name = std::string{"Random scenario "} + seedString;
+    options.description = std::string{"Random scenario based on template '"} + settings.name
+                          + std::string{"'. Seed: "} + seedString
+                          + ". Starting gold: " + std::to_string(settings.startingGold)
+                          + ". Roads: " + std::to_string(settings.roads)
+                          + "%. Forest: " + std::to_string(settings.forest) + "%.";
+    if (engine != RandomEngine::MersenneTwister) {
+        options.description += std::string{" Random engine: "} + getRandomEngineName(engine) + '.';
+    }
+
+    options.randomEngine = engine;
+    options.size = settings.size;
+
+    return options;
+}
+
+void readScenarioContents(MapGenerator& generator, MapTemplate& mapTemplate, sol::state& lua)
+{
+    // Cleanup previous contents, if any
+    mapTemplate.contents = MapTemplateContents();
+
+    mapTemplate.settings.replaceRandomRaces(generator.randomGenerator);
+    // Generate template contents
+    readTemplateContents(mapTemplate, lua);
+}
+
+MapPtr generateScenario(MapGenerator& generator, MapTemplate& mapTemplate, sol::state& lua)
+{
+    readScenarioContents(generator, mapTemplate, lua);
+    return generator.generate();
+}
+
+std::time_t getAttemptSeed(std::time_t seed, std::size_t attempt)
+{
+    if (!attempt) {
+        return seed;
+    }
+
+    // Scenario stores 32 bit seed, keep derived ones positive so they can be entered by user
+    const auto derived{deriveSeed(static_cast<std::uint64_t>(seed), attempt)};
+    return static_cast<std::time_t>(derived & 0x7fffffffu);
+}
+
+GeneratedScenario generateWithRetries(LuaStatePool& templates,
+                                      const MapTemplateSettings& settings,
+                                      std::time_t seed,
+                                      std::size_t attemptsTotal,
+                                      std::size_t threads,
+                                      RandomEngine engine)
+{
+    attemptsTotal = std::max<std::size_t>(attemptsTotal, 1);
+
+    std::size_t threadsTotal{threads};
+    if (!threadsTotal) {
+        threadsTotal = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    threadsTotal = std::min(threadsTotal, attemptsTotal);
+
+    std::vector<GeneratedScenario> results(attemptsTotal);
+    std::vector<std::exception_ptr> errors(attemptsTotal);
+    // Attempts after decisive one are cancelled
+    std::unique_ptr<std::atomic<bool>[]> cancelFlags{new std::atomic<bool>[attemptsTotal]{}};
+
+    std::atomic<std::size_t> nextAttempt{0};
+    // First attempt in seed order whose outcome does not depend on free space
+    std::atomic<std::size_t> decisiveAttempt{attemptsTotal};
+
+    auto setDecisive = [&decisiveAttempt, &cancelFlags, attemptsTotal](std::size_t attempt) {
+        auto current{decisiveAttempt.load()};
+        while (attempt < current && !decisiveAttempt.compare_exchange_weak(current, attempt)) {
+        }
+
+        for (auto i = attempt + 1; i < attemptsTotal; ++i) {
+            cancelFlags[i] = true;
+        }
+    };
+
+    auto worker = [&]() {
+        for (auto index = nextAttempt++; index < attemptsTotal && index < decisiveAttempt;
+             index = nextAttempt++) {
+            try {
+                const std::time_t attemptSeed{getAttemptSeed(seed, index)};
+
+                auto mapTemplate{std::make_unique<MapTemplate>()};
+                mapTemplate->settings = settings;
+
+                MapGenOptions options{createMapGenOptions(*mapTemplate, attemptSeed, engine)};
+                // Attempts already run in parallel
+                options.threads = threadsTotal > 1 ? 1 : threads;
+                auto generator{std::make_unique<MapGenerator>(options, attemptSeed)};
+                generator->setCancelFlag(&cancelFlags[index]);
+
+                {
+                    // Template is already executed, settings are chosen by user.
+                    // State is returned as soon as contents are read, so concurrent attempts
+                    // do not keep executed states for the whole generation
+                    auto lease{templates.acquire()};
+                    readScenarioContents(*generator, *mapTemplate, lease.getLua());
+                }
+
+                auto map{generator->generate()};
+
+                auto& result{results[index]};
+                result.mapTemplate = std::move(mapTemplate);
+                result.generator = std::move(generator);
+                result.map = std::move(map);
+                result.seed = attemptSeed;
+                result.attempt = index;
+
+                setDecisive(index);
+            } catch (const GenerationCancelledException&) {
+                // Earlier attempt is decisive, result of this one is not needed
+            } catch (const LackOfSpaceException&) {
+                errors[index] = std::current_exception();
+            } catch (const std::exception&) {
+                errors[index] = std::current_exception();
+                setDecisive(index);
+            }
+        }
+    };
+
+    // Current thread generates too
+    runInThreads(threadsTotal, worker);
+
+    const std::size_t decisive{decisiveAttempt};
+    if (decisive == attemptsTotal) {
+        // All attempts lack space, report problem of requested seed
+        std::rethrow_exception(errors.front());
+    }
+
+    if (errors[decisive]) {
+        std::rethrow_exception(errors[decisive]);
+    }
+
+    return std::move(results[decisive]);
+}
+
+BatchResult generateBatch(const BatchOptions& options)
+{
+    // Each seed executes template in a new state by default, so state left by template code
+    // for one seed does not affect scenarios of other seeds
+    LuaStatePoolOptions poolOptions;
+    poolOptions.discardStates = !options.reuseStates;
+
+    LuaStatePool templates{options.templatePath, poolOptions};
+
+    {
+        // Make sure template and options are correct before starting workers
+        auto lease{templates.acquire()};
+        checkBatchOptions(lease.getSettings(), options);
+    }
+
+    const auto seedsTotal{static_cast<std::size_t>(options.lastSeed - options.firstSeed) + 1};
+
+    std::size_t threadsTotal{options.threads};
+    if (!threadsTotal) {
+        threadsTotal = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    threadsTotal = std::min(threadsTotal, seedsTotal);
+
+    std::atomic<std::size_t> nextSeed{0};
+    std::atomic<std::size_t> generated{0};
+
+    std::mutex failuresMutex;
+    BatchResult result;
+
+    auto addFailure = [&failuresMutex, &result](std::time_t seed, std::string error) {
+        std::lock_guard<std::mutex> lock(failuresMutex);
+        result.failures.emplace_back(seed, std::move(error));
+    };
+
+    auto worker = [&options, &templates, &nextSeed, &generated, &addFailure, seedsTotal,
+                   threadsTotal]() {
+        for (auto index = nextSeed++; index < seedsTotal; index = nextSeed++) {
+            const std::time_t seed{options.firstSeed + static_cast<std::time_t>(index)};
+
+            try {
+                MapTemplate mapTemplate;
+                std::unique_ptr<MapGenerator> generator;
+
+                {
+                    // State is returned as soon as contents are read
+                    auto lease{templates.acquire()};
+
+                    mapTemplate.settings = lease.getSettings();
+                    applyBatchOptions(mapTemplate.settings, options);
+
+                    MapGenOptions genOptions{
+                        createMapGenOptions(mapTemplate, seed, options.randomEngine)};
+                    // Seeds already run in parallel
+                    genOptions.threads = threadsTotal > 1 ? 1 : options.threads;
+                    generator = std::make_unique<MapGenerator>(genOptions, seed);
+
+                    readScenarioContents(*generator, mapTemplate, lease.getLua());
+                }
+
+                auto map{generator->generate()};
+
+                const auto fileName{std::to_string(seed) + ".sg"};
+                map->serialize(options.outputFolder / fileName);
+
+                ++generated;
+            } catch (const std::exception& e) {
+                addFailure(seed, e.what());
+            }
+        }
+    };
+
+    runInThreads(threadsTotal, worker);
+
+    std::sort(result.failures.begin(), result.failures.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    result.generated = generated;
+    return result;
+}
+
+} // namespace rsg
@@ -0,0 +1,127 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mapgenerator.h"
+#include "maptemplate.h"
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sol {
+class state;
+}
+
+namespace rsg {
+
+class LuaStatePool;
+
+// Returns generator options for scenario created from template with specified seed.
+// Engine other than default one is recorded in description, so the scenario can be reproduced
+MapGenOptions createMapGenOptions(const MapTemplate& mapTemplate,
+                                  std::time_t seed,
+                                  RandomEngine engine = RandomEngine::MersenneTwister);
+
+// Replaces random races and evaluates template contents using generator random seed.
+// Template must be already executed in 'lua' state and its settings (size, races)
+// must be chosen by user. Lua state is not used by generator.generate() afterwards.
+// Throws exception in case of errors.
+void readScenarioContents(MapGenerator& generator, MapTemplate& mapTemplate, sol::state& lua);
+
+// Generates scenario map using generator created for specified template.
+// Template must be already executed in 'lua' state and its settings (size, races)
+// must be chosen by user. Random races are replaced and template contents
+// are evaluated anew using generator random seed.
+// Throws exception in case of errors.
+MapPtr generateScenario(MapGenerator& generator, MapTemplate& mapTemplate, sol::state& lua);
+
+// Scenario created by generateWithRetries() along with generator that created it
+struct GeneratedScenario
+{
+    // Template that generator refers to
+    std::unique_ptr<MapTemplate> mapTemplate;
+    std::unique_ptr<MapGenerator> generator;
+    MapPtr map;
+    // Seed scenario was generated with
+    std::time_t seed{};
+    // Index of successful attempt, 0 means requested seed was used
+    std::size_t attempt{};
+};
+
+// Returns seed used by specified generation attempt.
+// Attempt 0 uses requested seed, others use seeds derived from it
+std::time_t getAttemptSeed(std::time_t seed, std::size_t attempt);
+
+// Generates scenario from template with specified settings chosen by user.
+// When zones lack space for their contents, generation is repeated with seeds
+// from getAttemptSeed(). Attempts run concurrently, each one checks out a Lua state
+// from the pool only while it reads template contents.
+// Result of the first attempt in seed order that did not fail due to lack of space is used,
+// later attempts are cancelled. The result depends only on template, settings and seed.
+// Attempts running in parallel generate single threaded.
+// GameInfo and generator settings must be set up beforehand.
+// Throws exception of that attempt if it failed or LackOfSpaceException if all attempts did.
+GeneratedScenario generateWithRetries(LuaStatePool& templates,
+                                      const MapTemplateSettings& settings,
+                                      std::time_t seed,
+                                      std::size_t attemptsTotal = 8,
+                                      std::size_t threads = 0,
+                                      RandomEngine engine = RandomEngine::MersenneTwister);
+
+// Settings of batch scenario generation
+struct BatchOptions
+{
+    std::filesystem::path templatePath;
+    // Folder where to save created scenarios, each one is named by its seed
+    std::filesystem::path outputFolder;
+    // Races chosen by player, missing ones are considered random
+    std::vector<RaceType> races;
+    int size{48};
+    // Inclusive range of seeds
+    std::time_t firstSeed{};
+    std::time_t lastSeed{};
+    // Number of worker threads, 0 means use all hardware threads
+    std::size_t threads{};
+    RandomEngine randomEngine{RandomEngine::MersenneTwister};
+    // Reuse Lua states between seeds instead of closing them with their arenas.
+    // Only for templates that do not change library tables, see LuaStatePool
+    bool reuseStates{};
+};
+
+struct BatchResult
+{
+    std::size_t generated{};
+    // Seeds of scenarios that failed to generate, with error descriptions. Sorted by seed
+    std::vector<std::pair<std::time_t, std::string>> failures;
+};
+
+// Generates scenario for each seed in range using a pool of worker threads.
+// Each seed is generated single threaded when there are several workers.
+// GameInfo and generator settings must be set up beforehand, they are shared between workers.
+// Template is executed anew for each seed in a new Lua state, unless states are reused.
+// So scenario generated for a seed is the same as the one generated alone,
+// regardless of order seeds are handled in.
+// Throws exception if template or options are invalid.
+BatchResult generateBatch(const BatchOptions& options);
+
+} // namespace rsg
@@ -0,0 +1,42 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bytesink.h"
+#include <fstream>
+#include <stdexcept>
+
+namespace rsg {
+
+void FileSink::flush()
+{
+    std::ofstream stream{filePath, std::ios_base::binary};
+    if (!stream.is_open()) {
+        throw std::runtime_error("Could not open file " + filePath.string() + " for writing");
+    }
+
+    const auto& data{getData()};
+    stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+    stream.close();
+
+    if (!stream) {
+        throw std::runtime_error("Could not write file " + filePath.string());
+    }
+}
+
+} // namespace rsg
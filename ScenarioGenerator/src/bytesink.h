@@ -0,0 +1,105 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <utility>
+#include <vector>
+
+namespace rsg {
+
+// Destination of serialized scenario bytes
+class ByteSink
+{
+public:
+    virtual ~ByteSink() = default;
+
+    virtual void write(const void* data, std::size_t byteCount) = 0;
+    // Writes specified number of zero bytes
+    virtual void writeZeros(std::size_t byteCount) = 0;
+
+    // Hints sink about expected total number of bytes
+    virtual void reserve(std::size_t)
+    { }
+};
+
+// Collects bytes in a contiguous growable buffer
+class MemorySink : public ByteSink
+{
+public:
+    MemorySink() = default;
+
+    MemorySink(std::size_t expectedSize)
+    {
+        buffer.reserve(expectedSize);
+    }
+
+    ~MemorySink() override = default;
+
+    void write(const void* data, std::size_t byteCount) override
+    {
+        const auto bytes{static_cast<const char*>(data)};
+        buffer.insert(buffer.end(), bytes, bytes + byteCount);
+    }
+
+    void writeZeros(std::size_t byteCount) override
+    {
+        buffer.resize(buffer.size() + byteCount, '\0');
+    }
+
+    void reserve(std::size_t byteCount) override
+    {
+        buffer.reserve(byteCount);
+    }
+
+    const std::vector<char>& getData() const
+    {
+        return buffer;
+    }
+
+    // Moves collected bytes out of the sink, leaving it empty
+    std::vector<char> release()
+    {
+        return std::move(buffer);
+    }
+
+private:
+    std::vector<char> buffer;
+};
+
+// Collects bytes in memory and writes them to a file at once
+class FileSink : public MemorySink
+{
+public:
+    FileSink(const std::filesystem::path& filePath)
+        : filePath{filePath}
+    { }
+
+    ~FileSink() override = default;
+
+    // Writes collected bytes to the file, throws std::runtime_error on failure
+    void flush();
+
+private:
+    std::filesystem::path filePath;
+};
+
+} // namespace rsg
@@ -0,0 +1,78 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "distancefield.h"
+#include "mapgenerator.h"
+#include "tileset.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace rsg {
+
+void DistanceField::insert(const Position& tile)
+{
+    entries.insert(Entry{mapGenerator->getNearestObjectDistance(tile), tile});
+}
+
+void DistanceField::erase(const Position& tile)
+{
+    entries.erase(Entry{mapGenerator->getNearestObjectDistance(tile), tile});
+}
+
+void DistanceField::addObject(const Position& object, const TileSet& tiles)
+{
+    if (entries.empty()) {
+        return;
+    }
+
+    // Tiles farther than sqrt(maxDistance) along any axis
+    // are already closer to some other object, skip them
+    const int radius{static_cast<int>(std::sqrt(getMaxDistance())) + 1};
+    const int size{mapGenerator->mapGenOptions.size};
+
+    const int startX{std::max(0, object.x - radius)};
+    const int endX{std::min(size - 1, object.x + radius)};
+    const int startY{std::max(0, object.y - radius)};
+    const int endY{std::min(size - 1, object.y + radius)};
+
+    for (int y = startY; y <= endY; ++y) {
+        for (int x = startX; x <= endX; ++x) {
+            const Position tile{x, y};
+            if (!tiles.contains(tile)) {
+                continue;
+            }
+
+            const auto distance{static_cast<float>(object.distanceSquared(tile))};
+            const auto currentDistance{mapGenerator->getNearestObjectDistance(tile)};
+
+            if (distance >= currentDistance) {
+                continue;
+            }
+
+            [[maybe_unused]] const auto erased{entries.erase(Entry{currentDistance, tile})};
+            assert(erased == 1);
+
+            mapGenerator->setNearestObjectDistance(tile, distance);
+            entries.insert(Entry{mapGenerator->getNearestObjectDistance(tile), tile});
+        }
+    }
+}
+
+} // namespace rsg
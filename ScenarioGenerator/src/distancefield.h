@@ -0,0 +1,94 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "position.h"
+#include <set>
+#include <utility>
+
+namespace rsg {
+
+class MapGenerator;
+class TileSet;
+
+// Squared distances from zone tiles to the nearest placed object.
+// Distances are stored in TileInfo, the field keeps tracked tiles ordered
+// from the farthest to the closest, ties are ordered the same way std::set<Position> does.
+class DistanceField
+{
+public:
+    DistanceField(MapGenerator* mapGenerator)
+        : mapGenerator{mapGenerator}
+    { }
+
+    // Starts tracking tile with its current distance
+    void insert(const Position& tile);
+    void erase(const Position& tile);
+
+    // Updates distances of 'tiles' after object was placed at specified position.
+    // Only tiles that can get closer to the object than the farthest tracked one are checked.
+    // All 'tiles' must be tracked
+    void addObject(const Position& object, const TileSet& tiles);
+
+    // Returns distance of the farthest tracked tile or 0 if nothing is tracked
+    float getMaxDistance() const
+    {
+        return entries.empty() ? 0.f : entries.begin()->first;
+    }
+
+    // Searches for the farthest tracked tile with distance greater than zero and not less
+    // than 'minDistance' that satisfies 'isSuitable(tile)'. Returns true if tile was found
+    template <typename F>
+    bool findFarthest(float minDistance, F&& isSuitable, Position& result) const
+    {
+        for (const auto& [distance, tile] : entries) {
+            if (distance < minDistance || distance <= 0.f) {
+                break;
+            }
+
+            if (isSuitable(tile)) {
+                result = tile;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+private:
+    using Entry = std::pair<float, Position>;
+
+    struct EntryComparer
+    {
+        bool operator()(const Entry& a, const Entry& b) const
+        {
+            if (a.first != b.first) {
+                return a.first > b.first;
+            }
+
+            return a.second < b.second;
+        }
+    };
+
+    std::set<Entry, EntryComparer> entries;
+    MapGenerator* mapGenerator{};
+};
+
+} // namespace rsg
@@ -30,6 +30,13 @@ public:
     using std::runtime_error::runtime_error;
 };
 
+// Template script exceeded instruction or memory limit from generator settings
+class TemplateLimitException : public TemplateException
+{
+public:
+    using TemplateException::TemplateException;
+};
+
 // Exception during zone contents generation.
 // Some objects could not be placed due to lack of free space in zone.
 // It means generator failed to keep a promise to generate scenario
@@ -40,4 +47,11 @@ public:
     using std::runtime_error::runtime_error;
 };
 
+// Generation was stopped from outside, its results are not needed anymore
+class GenerationCancelledException : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
 } // namespace rsg
@@ -72,6 +72,8 @@ static void readStringSet(std::set<CMidgardID>& ids, const StringSet& stringSet)
 static void readGeneratorOptions(const sol::table& table)
 {
     generatorSettings.iterations = readValue(table, "iterations", 100, 100, 1000000);
+    generatorSettings.templateInstructionLimit = readValue(table, "templateInstructionLimit", 0, 0, 1000000);
+    generatorSettings.templateMemoryLimit = readValue(table, "templateMemoryLimit", 0, 0, 65536);
     generatorSettings.maxTemplateCustomParameters = readValue(table, "maxTemplateCustomParameters", 0, 0, 255);
     generatorSettings.enableParameterForest = readValue(table, "enableParameterForest", true);
     generatorSettings.enableParameterRoads = readValue(table, "enableParameterRoads", true);
@@ -364,6 +366,11 @@ const GeneratorSettings& getGeneratorSettings()
     return generatorSettings;
 }
 
+void setGeneratorSettings(GeneratorSettings&& settings)
+{
+    generatorSettings = std::move(settings);
+}
+
 std::uint8_t getRandomTreeImageIndex(RandomGenerator& rand)
 {
     return rand.nextInteger(std::uint8_t{0}, getGeneratorSettings().maxTreeImageIndex);
@@ -85,6 +85,10 @@ struct GeneratorSettings
     std::uint8_t maxTreeImageIndex{};
     // Number of iterations for placing zones within an attempt
     std::uint32_t iterations{};
+    // Millions of Lua instructions template can execute while read or evaluated, 0 - no limit
+    std::uint32_t templateInstructionLimit{};
+    // Megabytes of Lua memory template can allocate while read or evaluated, 0 - no limit
+    std::uint32_t templateMemoryLimit{};
     // Maximum number of custom template parameters
     std::uint8_t maxTemplateCustomParameters{};
     // Enable forest spin on template generation page
@@ -100,6 +104,8 @@ struct GeneratorSettings
 bool readGeneratorSettings(const std::filesystem::path& gameFolderPath);
 
 const GeneratorSettings& getGeneratorSettings();
+// Replaces current settings, for example with ones restored from cache
+void setGeneratorSettings(GeneratorSettings&& settings);
 
 std::uint8_t getRandomTreeImageIndex(RandomGenerator& rand);
 
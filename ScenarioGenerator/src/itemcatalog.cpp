@@ -0,0 +1,119 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "itemcatalog.h"
+#include "containers.h"
+#include "gameinfo.h"
+#include "generatorsettings.h"
+#include "iteminfo.h"
+#include "itempicker.h"
+#include "randomgenerator.h"
+#include <algorithm>
+
+namespace rsg {
+
+void ItemCatalog::build(const std::set<CMidgardID>& forbiddenOnTemplate)
+{
+    for (auto& items : itemsByType) {
+        items.clear();
+    }
+
+    for (const ItemInfo* info : getGameInfo()->getItems()) {
+        if (noSpecialItem(info) || noForbiddenItem(info)
+            || contains(forbiddenOnTemplate, info->getItemId())) {
+            continue;
+        }
+
+        const auto type{static_cast<std::size_t>(info->getItemType())};
+        if (type >= itemTypesTotal) {
+            // Game info from other sources is not guaranteed to be validated
+            continue;
+        }
+
+        itemsByType[type].push_back(info);
+    }
+
+    // Stable sort keeps items of the same value in game info order
+    for (auto& items : itemsByType) {
+        std::stable_sort(items.begin(), items.end(), [](const ItemInfo* a, const ItemInfo* b) {
+            return a->getValue() < b->getValue();
+        });
+    }
+}
+
+const ItemInfo* ItemCatalog::pick(RandomGenerator& random,
+                                  const std::set<ItemType>& types,
+                                  bool noValuables,
+                                  int minValue,
+                                  int maxValue) const
+{
+    if (minValue > maxValue) {
+        return nullptr;
+    }
+
+    using Range = std::pair<const ItemInfo* const*, std::size_t /* items */>;
+
+    // Suitable items of each type form a contiguous range
+    std::array<Range, itemTypesTotal> ranges{};
+    std::size_t total{};
+
+    for (std::size_t i = 0; i < itemTypesTotal; ++i) {
+        const auto type{static_cast<ItemType>(i)};
+        if (noValuables && type == ItemType::Valuable) {
+            continue;
+        }
+
+        if (!types.empty() && types.find(type) == types.end()) {
+            continue;
+        }
+
+        const auto& items{itemsByType[i]};
+
+        const auto begin{std::lower_bound(items.begin(), items.end(), minValue,
+                                          [](const ItemInfo* info, int value) {
+                                              return info->getValue() < value;
+                                          })};
+        const auto end{std::upper_bound(begin, items.end(), maxValue,
+                                        [](int value, const ItemInfo* info) {
+                                            return value < info->getValue();
+                                        })};
+
+        const auto count{static_cast<std::size_t>(std::distance(begin, end))};
+        ranges[i] = Range{items.data() + std::distance(items.begin(), begin), count};
+        total += count;
+    }
+
+    if (!total) {
+        // Constraints are too tight, nothing to pick
+        return nullptr;
+    }
+
+    std::size_t index{random.nextInteger(std::size_t{0}, total - 1)};
+    for (const auto& [items, count] : ranges) {
+        if (index < count) {
+            return items[index];
+        }
+
+        index -= count;
+    }
+
+    return nullptr;
+}
+
+} // namespace rsg
@@ -0,0 +1,58 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "enums.h"
+#include "rsgid.h"
+#include <array>
+#include <cstddef>
+#include <set>
+#include <vector>
+
+namespace rsg {
+
+class ItemInfo;
+class RandomGenerator;
+
+// Items allowed for random loot, grouped by type and sorted by value.
+// Built once per generation so loot picks do not filter the whole item pool each time
+class ItemCatalog
+{
+public:
+    // Collects all items except special and forbidden ones
+    void build(const std::set<CMidgardID>& forbiddenOnTemplate);
+
+    // Picks random item of allowed types with value in [minValue : maxValue] range.
+    // Empty 'types' allows items of any type.
+    // Each suitable item has the same chance to be picked.
+    // Returns nullptr if there are no suitable items
+    const ItemInfo* pick(RandomGenerator& random,
+                         const std::set<ItemType>& types,
+                         bool noValuables,
+                         int minValue,
+                         int maxValue) const;
+
+private:
+    static constexpr std::size_t itemTypesTotal{static_cast<std::size_t>(ItemType::Special) + 1};
+
+    std::array<std::vector<const ItemInfo*>, itemTypesTotal> itemsByType;
+};
+
+} // namespace rsg
@@ -0,0 +1,127 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "luaarena.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace rsg {
+
+LuaArena::~LuaArena()
+{
+    for (auto chunk : chunks) {
+        std::free(chunk);
+    }
+}
+
+void* LuaArena::allocate(void* arena, void* block, std::size_t oldSize, std::size_t newSize)
+{
+    // Size of a new block is a Lua object type, not a size
+    if (!block) {
+        oldSize = 0;
+    }
+
+    return static_cast<LuaArena*>(arena)->reallocate(block, oldSize, newSize);
+}
+
+void* LuaArena::reallocate(void* block, std::size_t oldSize, std::size_t newSize)
+{
+    if (!newSize) {
+        if (block) {
+            freeBlock(block, oldSize);
+            usedBytes -= oldSize;
+        }
+
+        return nullptr;
+    }
+
+    void* result{};
+
+    if (block && isSmall(oldSize) && isSmall(newSize)
+        && getSizeClass(oldSize) == getSizeClass(newSize)) {
+        // Block is large enough already
+        result = block;
+    } else if (block && !isSmall(oldSize) && !isSmall(newSize)) {
+        result = std::realloc(block, newSize);
+    } else {
+        result = allocateBlock(newSize);
+
+        if (result && block) {
+            std::memcpy(result, block, std::min(oldSize, newSize));
+            freeBlock(block, oldSize);
+        }
+    }
+
+    if (result) {
+        usedBytes = usedBytes - oldSize + newSize;
+    }
+
+    return result;
+}
+
+void* LuaArena::allocateBlock(std::size_t size)
+{
+    if (!isSmall(size)) {
+        return std::malloc(size);
+    }
+
+    const auto sizeClass{getSizeClass(size)};
+
+    auto& freeList{freeLists[sizeClass]};
+    if (freeList) {
+        auto block{freeList};
+        freeList = block->next;
+        return block;
+    }
+
+    const std::size_t blockSize{(sizeClass + 1) * granularity};
+
+    if (static_cast<std::size_t>(chunkEnd - chunkCurrent) < blockSize) {
+        // Rest of current chunk is abandoned, it is smaller than the largest small block
+        auto chunk{static_cast<char*>(std::malloc(chunkSize))};
+        if (!chunk) {
+            return nullptr;
+        }
+
+        chunks.push_back(chunk);
+        chunkCurrent = chunk;
+        chunkEnd = chunk + chunkSize;
+    }
+
+    auto block{chunkCurrent};
+    chunkCurrent += blockSize;
+    return block;
+}
+
+void LuaArena::freeBlock(void* block, std::size_t size)
+{
+    if (!isSmall(size)) {
+        std::free(block);
+        return;
+    }
+
+    auto freeBlock{static_cast<FreeBlock*>(block)};
+    auto& freeList{freeLists[getSizeClass(size)]};
+
+    freeBlock->next = freeList;
+    freeList = freeBlock;
+}
+
+} // namespace rsg
@@ -0,0 +1,83 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace rsg {
+
+// Memory of a single Lua state.
+// Small blocks are carved from large chunks and recycled through per size free lists,
+// so tables created by templates do not reach system allocator.
+// Chunks are released at once when arena is destroyed, after Lua state is closed.
+// Arena is used by a single Lua state and is not thread safe.
+class LuaArena
+{
+public:
+    LuaArena() = default;
+    ~LuaArena();
+
+    LuaArena(const LuaArena&) = delete;
+    LuaArena& operator=(const LuaArena&) = delete;
+
+    // lua_Alloc compatible function, 'arena' is a pointer to LuaArena
+    static void* allocate(void* arena, void* block, std::size_t oldSize, std::size_t newSize);
+
+    // Returns number of bytes currently used by Lua state
+    std::size_t getUsedBytes() const
+    {
+        return usedBytes;
+    }
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    static constexpr std::size_t granularity{16};
+    static constexpr std::size_t maxSmallSize{512};
+    static constexpr std::size_t chunkSize{256 * 1024};
+
+    void* reallocate(void* block, std::size_t oldSize, std::size_t newSize);
+    void* allocateBlock(std::size_t size);
+    void freeBlock(void* block, std::size_t size);
+
+    static bool isSmall(std::size_t size)
+    {
+        return size <= maxSmallSize;
+    }
+
+    // Returns free list index of small block
+    static std::size_t getSizeClass(std::size_t size)
+    {
+        return (size + granularity - 1) / granularity - 1;
+    }
+
+    std::array<FreeBlock*, maxSmallSize / granularity> freeLists{};
+    std::vector<void*> chunks;
+    char* chunkCurrent{};
+    char* chunkEnd{};
+    std::size_t usedBytes{};
+};
+
+} // namespace rsg
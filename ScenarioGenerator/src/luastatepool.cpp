@@ -0,0 +1,177 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "luastatepool.h"
+#include "maptemplatereader.h"
+
+namespace rsg {
+
+// Remembers global variables, metatable of globals and loaded modules
+// and returns function that restores them.
+// Library functions are kept in locals so template can not break restoring
+static const char snapshotGlobals[] = R"(
+    local next, rawget, rawset, globals = next, rawget, rawset, _G
+    local getmetatable, setmetatable = getmetatable, setmetatable
+    local loaded = package and package.loaded
+
+    local function snapshot(t)
+        local values = {}
+        for key, value in next, t do
+            values[key] = value
+        end
+
+        return values
+    end
+
+    local function restore(t, values)
+        for key in next, t do
+            if rawget(values, key) == nil then
+                rawset(t, key, nil)
+            end
+        end
+
+        for key, value in next, values do
+            rawset(t, key, value)
+        end
+    end
+
+    local globalValues = snapshot(globals)
+    local globalsMetatable = getmetatable(globals)
+    local loadedValues = loaded and snapshot(loaded)
+
+    return function()
+        restore(globals, globalValues)
+        setmetatable(globals, globalsMetatable)
+
+        if loaded then
+            restore(loaded, loadedValues)
+        end
+    end
+)";
+
+LuaStatePool::Lease::Lease(LuaStatePool& pool, std::unique_ptr<Entry>&& entry)
+    : pool{&pool}
+    , entry{std::move(entry)}
+{ }
+
+LuaStatePool::Lease::~Lease()
+{
+    if (entry) {
+        pool->release(std::move(entry));
+    }
+}
+
+sol::state& LuaStatePool::Lease::getLua()
+{
+    return *entry->lua;
+}
+
+const MapTemplateSettings& LuaStatePool::Lease::getSettings() const
+{
+    return entry->settings;
+}
+
+LuaStatePool::LuaStatePool(const std::filesystem::path& templatePath,
+                           const LuaStatePoolOptions& options)
+    : templatePath{templatePath}
+    , options{options}
+{ }
+
+LuaStatePool::~LuaStatePool() = default;
+
+LuaStatePool::Lease LuaStatePool::acquire()
+{
+    const auto currentWriteTime{std::filesystem::last_write_time(templatePath)};
+    std::unique_ptr<Entry> entry;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (writeTime != currentWriteTime) {
+            // Template was changed, states executed old one are useless
+            idleEntries.clear();
+            writeTime = currentWriteTime;
+        }
+
+        if (!idleEntries.empty()) {
+            entry = std::move(idleEntries.back());
+            idleEntries.pop_back();
+        }
+    }
+
+    // Template is executed outside of the lock so other threads can check out states
+    if (!entry) {
+        entry = createEntry(currentWriteTime);
+    }
+
+    // Reused states execute template again, so its chunk locals and tables are created anew
+    entry->settings = readTemplateSettings(templatePath, *entry->lua);
+
+    return Lease{*this, std::move(entry)};
+}
+
+std::unique_ptr<LuaStatePool::Entry> LuaStatePool::createEntry(
+    std::filesystem::file_time_type writeTime) const
+{
+    auto entry{std::make_unique<Entry>()};
+    entry->arena = std::make_unique<LuaArena>();
+    entry->lua = std::make_unique<sol::state>(sol::default_at_panic, &LuaArena::allocate,
+                                              entry->arena.get());
+    entry->writeTime = writeTime;
+
+    sol::state& lua{*entry->lua};
+    bindLuaApi(lua);
+
+    if (options.setup) {
+        options.setup(lua);
+    }
+
+    if (options.memoryLimit) {
+        setTemplateMemoryLimit(lua, options.memoryLimit);
+    }
+
+    // State before template execution is restored when state is returned
+    entry->restoreGlobals = lua.script(snapshotGlobals);
+
+    return entry;
+}
+
+void LuaStatePool::release(std::unique_ptr<Entry>&& entry)
+{
+    if (options.discardStates) {
+        return;
+    }
+
+    auto result{entry->restoreGlobals()};
+    if (!result.valid()) {
+        // State can not be reset, do not reuse it
+        return;
+    }
+
+    // Return memory of template contents to the arena so next evaluation reuses it
+    entry->lua->collect_garbage();
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (entry->writeTime == writeTime) {
+        idleEntries.push_back(std::move(entry));
+    }
+}
+
+} // namespace rsg
@@ -0,0 +1,117 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "luaarena.h"
+#include "maptemplate.h"
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <sol/sol.hpp>
+#include <vector>
+
+namespace rsg {
+
+struct LuaStatePoolOptions
+{
+    // Called for each new state after api is bound and before template is executed
+    void (*setup)(sol::state& lua){};
+    // Maximum number of bytes template can allocate by each execution or contents evaluation,
+    // 0 means no limit. See setTemplateMemoryLimit()
+    std::size_t memoryLimit{};
+    // Close states when they are returned instead of reusing them, so each lease gets
+    // template executed in a new state. Their arenas with all template tables are released at once.
+    // Reused states do not reset everything template could change, see LuaStatePool
+    bool discardStates{true};
+};
+
+// Thread safe pool of Lua states with scenario generator api bound and template executed.
+// Template is executed each time state is checked out.
+// Unless states are discarded, returned states are reused: global variables,
+// metatable of globals and package.loaded are restored to values they had before
+// template execution. Changes template made inside library tables (math, string, ...),
+// string metatable and math.random state carry over to the next lease.
+// Templates that change them must use pools that discard states,
+// otherwise scenario of a seed could depend on which lease was used before.
+// Pool must outlive its leases.
+class LuaStatePool
+{
+    struct Entry;
+
+public:
+    // State checked out from the pool, returns it back when destroyed
+    class Lease
+    {
+    public:
+        Lease(LuaStatePool& pool, std::unique_ptr<Entry>&& entry);
+        Lease(Lease&& other) = default;
+        Lease& operator=(Lease&& other) = delete;
+        ~Lease();
+
+        sol::state& getLua();
+        // Settings of executed template
+        const MapTemplateSettings& getSettings() const;
+
+    private:
+        LuaStatePool* pool;
+        std::unique_ptr<Entry> entry;
+    };
+
+    LuaStatePool(const std::filesystem::path& templatePath,
+                 const LuaStatePoolOptions& options = {});
+    ~LuaStatePool();
+
+    LuaStatePool(const LuaStatePool&) = delete;
+    LuaStatePool& operator=(const LuaStatePool&) = delete;
+
+    // Returns idle state or creates a new one and executes template in it.
+    // Idle states are dropped if template file was changed since they were created.
+    // Throws exception if template could not be executed
+    Lease acquire();
+
+    const std::filesystem::path& getTemplatePath() const
+    {
+        return templatePath;
+    }
+
+private:
+    struct Entry
+    {
+        // Memory of the state, must outlive it
+        std::unique_ptr<LuaArena> arena;
+        std::unique_ptr<sol::state> lua;
+        // Restores global variables to values they had before template execution
+        sol::protected_function restoreGlobals;
+        MapTemplateSettings settings;
+        std::filesystem::file_time_type writeTime;
+    };
+
+    std::unique_ptr<Entry> createEntry(std::filesystem::file_time_type writeTime) const;
+    void release(std::unique_ptr<Entry>&& entry);
+
+    std::filesystem::path templatePath;
+    LuaStatePoolOptions options;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Entry>> idleEntries;
+    // Modification time of template file idle states were created from
+    std::filesystem::file_time_type writeTime;
+};
+
+} // namespace rsg
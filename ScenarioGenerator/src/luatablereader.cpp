@@ -0,0 +1,157 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "luatablereader.h"
+#include "exceptions.h"
+
+namespace rsg {
+
+// Stack slots used by a single level of nested tables: table, field keys, field value
+// and protected call of a function with table and key
+static constexpr int stackPerLevel{5};
+
+// Reads table field with metamethods, runs inside lua_pcall
+static int getTable(lua_State* state)
+{
+    lua_gettable(state, 1);
+    return 1;
+}
+
+LuaTableReader::LuaTableReader(lua_State* state)
+    : state{state}
+    , top{lua_gettop(state)}
+{ }
+
+LuaTableReader::~LuaTableReader()
+{
+    // Values are left on the stack when conversion is interrupted by exception
+    lua_settop(state, top);
+}
+
+bool LuaTableReader::readBoolean(bool def)
+{
+    if (lua_type(state, -1) != LUA_TBOOLEAN) {
+        return def;
+    }
+
+    return lua_toboolean(state, -1) != 0;
+}
+
+std::string LuaTableReader::readString(const char* def)
+{
+    if (lua_type(state, -1) != LUA_TSTRING) {
+        return def;
+    }
+
+    std::size_t length{};
+    const char* string{lua_tolstring(state, -1, &length)};
+    return std::string(string, length);
+}
+
+void LuaTableReader::expectTable()
+{
+    expectType(LUA_TTABLE);
+}
+
+void LuaTableReader::expectType(int type)
+{
+    const int actualType{lua_type(state, -1)};
+    if (actualType == type) {
+        return;
+    }
+
+    if (actualType == LUA_TNIL) {
+        error(std::string("is missing, ") + lua_typename(state, type) + " expected");
+    }
+
+    error(std::string("must be a ") + lua_typename(state, type) + ", got "
+          + lua_typename(state, actualType));
+}
+
+void LuaTableReader::error(const std::string& description) const
+{
+    throw TemplateException("Invalid template contents: '" + getPath() + "' " + description);
+}
+
+bool LuaTableReader::hasMetatable(int index)
+{
+    if (!lua_getmetatable(state, index)) {
+        return false;
+    }
+
+    lua_pop(state, 1);
+    return true;
+}
+
+int LuaTableReader::getValue(int index, bool raw)
+{
+    if (raw) {
+        return lua_rawget(state, index);
+    }
+
+    // Arrange function, table and key for the call
+    lua_pushcfunction(state, getTable);
+    lua_pushvalue(state, index);
+    lua_rotate(state, -3, 2);
+    protectedCall(2);
+
+    return lua_type(state, -1);
+}
+
+void LuaTableReader::protectedCall(int arguments)
+{
+    if (lua_pcall(state, arguments, 1, 0) == LUA_OK) {
+        return;
+    }
+
+    // Error object is not converted, conversion could raise another error
+    const std::string message{lua_type(state, -1) == LUA_TSTRING ? lua_tostring(state, -1)
+                                                                  : "unknown error"};
+    lua_pop(state, 1);
+
+    error("could not be read: " + message);
+}
+
+void LuaTableReader::reserveStack()
+{
+    if (!lua_checkstack(state, stackPerLevel)) {
+        error("is nested too deep");
+    }
+}
+
+std::string LuaTableReader::getPath() const
+{
+    std::string result;
+
+    for (const auto& element : path) {
+        if (element.key) {
+            if (!result.empty()) {
+                result += '.';
+            }
+
+            result += element.key;
+        } else {
+            result += '[' + std::to_string(element.index) + ']';
+        }
+    }
+
+    return result.empty() ? "contents" : result;
+}
+
+} // namespace rsg
@@ -0,0 +1,325 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "randomgenerator.h"
+#include "rsgid.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <lua.hpp>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rsg {
+
+class LuaTableReader;
+
+// Describes how value of a table field is converted to a member of T.
+// Field without a key receives the table itself, several members can be read from it
+template <typename T>
+struct LuaField
+{
+    const char* key;
+    // Converts value on top of the stack, it is nil if field is missing
+    void (*read)(LuaTableReader& reader, T& object);
+};
+
+// Converts Lua tables into structures described by arrays of fields.
+// Keys of each field array are interned once per Lua state and kept in the registry,
+// so fields are looked up without hashing their names again.
+// Reader works with value on top of the stack and restores the stack when destroyed.
+// Lua calls that can raise errors, such as metamethods and allocations, are protected.
+// Errors are reported as TemplateException with path to the wrong value.
+class LuaTableReader
+{
+public:
+    LuaTableReader(lua_State* state);
+    ~LuaTableReader();
+
+    LuaTableReader(const LuaTableReader&) = delete;
+    LuaTableReader& operator=(const LuaTableReader&) = delete;
+
+    // Reads fields of a table, does nothing if value is not a table
+    template <typename T, std::size_t N>
+    void readObject(T& object, const LuaField<T> (&fields)[N])
+    {
+        if (!lua_istable(state, -1)) {
+            return;
+        }
+
+        reserveStack();
+
+        const int index{lua_absindex(state, -1)};
+        const bool raw{!hasMetatable(index)};
+        const int keysIndex{pushKeys(fields)};
+
+        for (std::size_t i = 0; i < N; ++i) {
+            const auto& field{fields[i]};
+
+            if (field.key) {
+                path.push_back({field.key, 0});
+                lua_rawgeti(state, keysIndex, static_cast<lua_Integer>(i + 1));
+                getValue(index, raw);
+            } else {
+                lua_pushvalue(state, index);
+            }
+
+            field.read(*this, object);
+
+            if (field.key) {
+                path.pop_back();
+            }
+
+            lua_pop(state, 1);
+        }
+
+        lua_pop(state, 1);
+    }
+
+    // Calls 'read' for each element of an array with element on top of the stack.
+    // Does nothing if value is not a table
+    template <typename Function>
+    void forEachElement(Function&& read)
+    {
+        if (!lua_istable(state, -1)) {
+            return;
+        }
+
+        reserveStack();
+
+        const int index{lua_absindex(state, -1)};
+        const bool raw{!hasMetatable(index)};
+
+        for (lua_Integer i = 1;; ++i) {
+            path.push_back({nullptr, i});
+            lua_pushinteger(state, i);
+
+            if (getValue(index, raw) == LUA_TNIL) {
+                path.pop_back();
+                lua_pop(state, 1);
+                break;
+            }
+
+            read();
+            path.pop_back();
+
+            lua_pop(state, 1);
+        }
+    }
+
+    // Reads array of tables, each element must be a table
+    template <typename T, std::size_t N>
+    void readObjects(std::vector<T>& objects, const LuaField<T> (&fields)[N])
+    {
+        if (lua_istable(state, -1)) {
+            objects.reserve(objects.size() + lua_rawlen(state, -1));
+        }
+
+        forEachElement([this, &objects, &fields]() {
+            expectTable();
+
+            T object{};
+            readObject(object, fields);
+            objects.push_back(std::move(object));
+        });
+    }
+
+    // Reads 'min' and 'max' fields of a table, swaps them if min is greater than max.
+    // Does nothing if value is not a table
+    template <typename T>
+    void readRandomValue(RandomValue<T>& value,
+                         T def,
+                         T min = std::numeric_limits<T>::min(),
+                         T max = std::numeric_limits<T>::max())
+    {
+        static const LuaField<Bounds<T>> fields[] = {
+            {"min", [](LuaTableReader& reader, Bounds<T>& bounds) {
+                 bounds.value.min = reader.readInteger(bounds.def, bounds.min, bounds.max);
+             }},
+            {"max", [](LuaTableReader& reader, Bounds<T>& bounds) {
+                 bounds.value.max = reader.readInteger(bounds.def, bounds.min, bounds.max);
+             }},
+        };
+
+        Bounds<T> bounds{value, def, min, max};
+        readObject(bounds, fields);
+
+        if (value.min > value.max) {
+            std::swap(value.min, value.max);
+        }
+    }
+
+    // Returns integer clamped to the bounds, or default value if value is not a number
+    template <typename T>
+    T readInteger(T def,
+                  T min = std::numeric_limits<T>::min(),
+                  T max = std::numeric_limits<T>::max())
+    {
+        if (lua_type(state, -1) != LUA_TNUMBER) {
+            return std::clamp<T>(def, min, max);
+        }
+
+        if (lua_isinteger(state, -1)) {
+            const lua_Integer integer{lua_tointeger(state, -1)};
+            return static_cast<T>(std::clamp<lua_Integer>(integer, static_cast<lua_Integer>(min),
+                                                          static_cast<lua_Integer>(max)));
+        }
+
+        const lua_Number number{lua_tonumber(state, -1)};
+        if (std::isnan(number)) {
+            return std::clamp<T>(def, min, max);
+        }
+
+        return static_cast<T>(std::llround(
+            std::clamp<lua_Number>(number, static_cast<lua_Number>(min),
+                                   static_cast<lua_Number>(max))));
+    }
+
+    // Returns enumeration value, or default value if value is not a number
+    template <typename T>
+    T readEnum(T def)
+    {
+        if (lua_type(state, -1) != LUA_TNUMBER) {
+            return def;
+        }
+
+        return static_cast<T>(lua_tointeger(state, -1));
+    }
+
+    // Returns enumeration value, throws if value is missing or is not a number
+    template <typename T>
+    T readRequiredEnum()
+    {
+        expectType(LUA_TNUMBER);
+        return static_cast<T>(lua_tointeger(state, -1));
+    }
+
+    // Reads array of enumeration values, does nothing if value is not a table
+    template <typename T>
+    void readEnums(std::set<T>& values)
+    {
+        forEachElement([this, &values]() { values.insert(readRequiredEnum<T>()); });
+    }
+
+    // Reads array of id strings into std::set or std::vector.
+    // Invalid and empty ids are skipped, does nothing if value is not a table
+    template <typename Container>
+    void readIds(Container& ids)
+    {
+        forEachElement([this, &ids]() {
+            expectType(LUA_TSTRING);
+
+            const CMidgardID id(lua_tostring(state, -1));
+            if (id != invalidId && id != emptyId) {
+                ids.insert(ids.end(), id);
+            }
+        });
+    }
+
+    bool isTable() const
+    {
+        return lua_istable(state, -1);
+    }
+
+    // Returns boolean value, or default value if value is not a boolean
+    bool readBoolean(bool def);
+    // Returns string value, or default value if value is not a string
+    std::string readString(const char* def);
+
+    // Throws if value is not a table
+    void expectTable();
+    // Throws if value has other type
+    void expectType(int type);
+
+    [[noreturn]] void error(const std::string& description) const;
+
+private:
+    struct PathElement
+    {
+        // Key of a field or nullptr for array element
+        const char* key;
+        lua_Integer index;
+    };
+
+    template <typename T>
+    struct Bounds
+    {
+        RandomValue<T>& value;
+        T def;
+        T min;
+        T max;
+    };
+
+    // Pushes array of interned field keys, creates it on first use in the Lua state.
+    // Returns stack index of the array
+    template <typename T, std::size_t N>
+    int pushKeys(const LuaField<T> (&fields)[N])
+    {
+        if (lua_rawgetp(state, LUA_REGISTRYINDEX, fields) == LUA_TNIL) {
+            lua_pop(state, 1);
+            lua_pushcfunction(state, (createKeys<T, N>));
+            lua_pushlightuserdata(state, const_cast<LuaField<T>*>(fields));
+            protectedCall(1);
+        }
+
+        return lua_gettop(state);
+    }
+
+    // Creates array of field keys passed as light userdata and stores it in the registry.
+    // Runs inside lua_pcall since allocations can fail
+    template <typename T, std::size_t N>
+    static int createKeys(lua_State* state)
+    {
+        const auto fields{static_cast<const LuaField<T>*>(lua_touserdata(state, 1))};
+        lua_createtable(state, static_cast<int>(N), 0);
+
+        for (std::size_t i = 0; i < N; ++i) {
+            if (fields[i].key) {
+                lua_pushstring(state, fields[i].key);
+                lua_rawseti(state, -2, static_cast<lua_Integer>(i + 1));
+            }
+        }
+
+        lua_pushvalue(state, -1);
+        lua_rawsetp(state, LUA_REGISTRYINDEX, fields);
+        return 1;
+    }
+
+    bool hasMetatable(int index);
+    // Replaces key on top of the stack with value of the table field.
+    // Tables with metatables are read in protected mode. Returns type of the value
+    int getValue(int index, bool raw);
+    // Calls function with arguments on top of the stack, leaves a single result.
+    // Throws TemplateException if Lua error was raised
+    void protectedCall(int arguments);
+    // Makes sure nested tables can be read without overflowing the stack
+    void reserveStack();
+    std::string getPath() const;
+
+    lua_State* state;
+    std::vector<PathElement> path;
+    int top;
+};
+
+} // namespace rsg
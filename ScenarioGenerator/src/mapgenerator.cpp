@@ -19,12 +19,14 @@
 
 #include "mapgenerator.h"
 #include "diplomacy.h"
+#include "exceptions.h"
 #include "fog.h"
 #include "image.h"
 #include "knownspells.h"
 #include "maptemplate.h"
 #include "player.h"
 #include "playerbuildings.h"
+#include "profiler.h"
 #include "road.h"
 #include "scenarioinfo.h"
 #include "scenariovariables.h"
@@ -91,10 +93,13 @@ PlayerSubraceIdPair MapGenerator::createPlayer(RaceType race)
 
 MapPtr MapGenerator::generate()
 {
+    StageTimer timer{"generate"};
+
     map = std::make_unique<Map>();
 
     addHeaderInfo();
     initTiles();
+    itemCatalog.build(mapGenOptions.mapTemplate->settings.forbiddenItems);
 
     // Create neutral player first
     auto playerSubraceIds{createPlayer(RaceType::Neutral)};
@@ -102,9 +107,11 @@ MapPtr MapGenerator::generate()
     neutralSubraceId = playerSubraceIds.second;
 
     generateZones();
+    checkCancelled();
     // Clear map so that all tiles are unguarded
     map->calculateGuardingCreaturePositions();
     fillZones();
+    checkCancelled();
 
     setupDiplomacy();
     addScenarioVariables();
@@ -112,6 +119,13 @@ MapPtr MapGenerator::generate()
     return std::move(map);
 }
 
+void MapGenerator::checkCancelled() const
+{
+    if (cancelFlag && cancelFlag->load(std::memory_order_relaxed)) {
+        throw GenerationCancelledException("Scenario generation was cancelled");
+    }
+}
+
 void MapGenerator::addHeaderInfo()
 {
     map->name = mapGenOptions.name;
@@ -139,10 +153,13 @@ void MapGenerator::initTiles()
     const auto total{map->size * map->size};
     tiles.resize(total);
     zoneColoring.resize(total);
+    pathFinder.resize(map->size);
 }
 
 void MapGenerator::generateZones()
 {
+    StageTimer timer{"generateZones"};
+
     auto tmpl = mapGenOptions.mapTemplate;
 
     zones.clear();
@@ -152,12 +169,23 @@ void MapGenerator::generateZones()
 
         auto zone = std::make_shared<TemplateZone>(this);
         zone->setOptions(*options);
+        zone->setRandomSeed(randomSeed, mapGenOptions.randomEngine);
         zones[zone->id] = zone;
     }
 
     ZonePlacer placer(this);
-    placer.placeZones(&randomGenerator);
-    placer.assignZones();
+
+    {
+        StageTimer placeTimer{"placeZones"};
+        placer.placeZones(&randomGenerator);
+    }
+
+    placementIterations = placer.getIterations();
+
+    {
+        StageTimer assignTimer{"assignZones"};
+        placer.assignZones();
+    }
 
     if (isDebugMode()) {
         std::cout << "Zones generated successfully\n";
@@ -184,21 +212,32 @@ void MapGenerator::fillZones()
     }
 
     for (auto& it : zones) {
+        checkCancelled();
+        StageTimer timer{"initTowns", it.first};
         it.second->initTowns();
     }
 
     // Make sure there are some free tiles in the zone
     for (auto& it : zones) {
+        checkCancelled();
+        StageTimer timer{"initFreeTiles", it.first};
         it.second->initFreeTiles();
     }
 
     for (auto& it : zones) {
+        checkCancelled();
+        StageTimer timer{"createBorder", it.first};
         it.second->createBorder();
     }
 
-    createDirectConnections();
+    {
+        StageTimer timer{"createDirectConnections"};
+        createDirectConnections();
+    }
 
     for (auto& it : zones) {
+        checkCancelled();
+        StageTimer timer{"fill", it.first};
         it.second->fill();
     }
 
@@ -208,8 +247,11 @@ void MapGenerator::fillZones()
         debugTiles("before createObstacles.png");
     }
 
-    // TODO: this is tightenObstacles() actually
-    createObstacles();
+    {
+        // TODO: this is tightenObstacles() actually
+        StageTimer timer{"tightenObstacles"};
+        createObstacles();
+    }
 
     if constexpr (debugObstacles) {
         debugTiles("after createObstacles.png");
@@ -220,6 +262,8 @@ void MapGenerator::fillZones()
     // In this case mountains on zone boundaries can be made bigger.
     // Place actual obstacles matching zone terrain
     for (auto& it : zones) {
+        checkCancelled();
+        StageTimer timer{"createObstacles", it.first};
         it.second->createObstacles();
     }
 
@@ -228,9 +272,12 @@ void MapGenerator::fillZones()
     }
 
     for (auto& it : zones) {
+        checkCancelled();
+        StageTimer timer{"connectRoads", it.first};
         it.second->connectRoads();
     }
 
+    StageTimer timer{"createRoads"};
     createRoads();
 }
 
@@ -417,7 +464,11 @@ void MapGenerator::setZoneId(const Position& position, TemplateZoneId zoneId)
 {
     checkIsOnMap(position);
 
-    zoneColoring[posToIndex(position)] = zoneId;
+    auto& coloring{zoneColoring[posToIndex(position)]};
+    if (coloring != zoneId) {
+        coloring = zoneId;
+        ++tilesVersion;
+    }
 }
 
 void MapGenerator::checkIsOnMap(const Position& position) const
@@ -476,7 +527,11 @@ void MapGenerator::setOccupied(const Position& position, TileType value)
 {
     checkIsOnMap(position);
 
-    tiles[posToIndex(position)].setOccupied(value);
+    auto& tile{tiles[posToIndex(position)]};
+    if (tile.getTileType() != value) {
+        tile.setOccupied(value);
+        ++tilesVersion;
+    }
 }
 
 void MapGenerator::setRoad(const Position& position, bool value)
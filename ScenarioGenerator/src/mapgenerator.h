@@ -20,11 +20,14 @@
 #pragma once
 
 #include "gameinfo.h"
+#include "itemcatalog.h"
+#include "pathfinder.h"
 #include "randomgenerator.h"
 #include "scenario/item.h"
 #include "scenario/map.h"
 #include "tileinfo.h"
 #include "zoneplacer.h"
+#include <atomic>
 #include <functional>
 #include <vector>
 
@@ -43,6 +46,10 @@ struct MapGenOptions
     int size{48};
     WaterContent waterContent{WaterContent::Random};
     MonsterStrength monsterStrength{MonsterStrength::Random};
+    RandomEngine randomEngine{RandomEngine::MersenneTwister};
+    // Number of threads generation stages can use, 0 means use all hardware threads.
+    // Callers that already generate in several threads set it to 1
+    std::size_t threads{};
 };
 
 class MapGenerator
@@ -55,7 +62,8 @@ public:
         , randomSeed{randomSeed}
         , debug{debug}
     {
-        randomGenerator.setSeed(static_cast<std::size_t>(randomSeed));
+        randomGenerator.setEngine(mapGenOptions.randomEngine);
+        randomGenerator.setSeed(static_cast<std::uint64_t>(randomSeed));
     }
 
     CMidgardID createId(CMidgardID::Type type)
@@ -173,11 +181,34 @@ public:
         return debug;
     }
 
+    // Changes each time tile type or tile zone changes
+    std::uint32_t getTilesVersion() const
+    {
+        return tilesVersion;
+    }
+
+    // Must be called after zoneColoring was changed directly
+    void zoneColoringChanged()
+    {
+        ++tilesVersion;
+    }
+
+    // Generation stops between stages once specified flag is set
+    void setCancelFlag(const std::atomic<bool>* flag)
+    {
+        cancelFlag = flag;
+    }
+
+    // Throws GenerationCancelledException if generation was cancelled
+    void checkCancelled() const;
+
     std::vector<TileInfo> tiles;
     std::vector<TemplateZoneId> zoneColoring;
     ZonesMap zones;
     std::map<RaceType, std::size_t> zonesPerRace;
     std::map<RaceType, PlayerSubraceIdPair> raceToPlayers;
+    PathFinder pathFinder;
+    ItemCatalog itemCatalog;
     MapPtr map;
     RandomGenerator randomGenerator;
     MapGenOptions mapGenOptions;
@@ -185,6 +216,10 @@ public:
     CMidgardID neutralPlayerId;
     CMidgardID neutralSubraceId;
     std::size_t zonesTotal{}; // Zones with capital town only
+    std::uint32_t tilesVersion{};
+    // Iterations made by zone placement, it can stop early when layout converges
+    int placementIterations{};
+    const std::atomic<bool>* cancelFlag{};
     bool debug{};
 };
 
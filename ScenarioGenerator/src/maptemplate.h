@@ -46,6 +46,11 @@ struct MapTemplateSettings
     int startingNativeMana{};
     int forest{}; // Percentage of unused tiles converted to forest after content placement
     uint32_t iterations{};
+    uint32_t placementRuns{}; // Independent zone placement runs, best one is used
+    // Zone placement stops early if its fitness improves by less than
+    // convergenceThreshold percent over convergenceWindow iterations, 0 window disables it
+    uint32_t convergenceWindow{};
+    float convergenceThreshold{};
 
     struct TemplateCustomParameter
     {
@@ -20,11 +20,20 @@
 #include "maptemplatereader.h"
 #include "containers.h"
 #include "exceptions.h"
+#include "generatorsettings.h"
+#include "luatablereader.h"
 #include "maptemplate.h"
+#include "privatefiles.h"
+#include <array>
+#include <cstdint>
+#include <cstdio>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <lua.hpp>
+#include <random>
 #include <sol/sol.hpp>
+#include <string>
 
 namespace rsg {
 
@@ -32,12 +41,357 @@ using OptionalTable = sol::optional<sol::table>;
 using OptionalTableArray = sol::optional<std::vector<sol::table>>;
 using StringSet = std::set<std::string>;
 
-static std::string readFile(const std::filesystem::path& file)
+// Key of compiled template signatures
+using CacheKey = std::array<std::uint64_t, 2>;
+
+// Folder with compiled templates, empty if caching is disabled
+static std::filesystem::path templateCacheFolder;
+static CacheKey templateCacheKey{};
+
+// Size of a signature that precedes bytecode in compiled template file
+static constexpr std::size_t signatureSize{sizeof(std::uint64_t)};
+
+static std::string readFile(const std::filesystem::path& file,
+                            std::ios::openmode mode = std::ios::in)
 {
-    std::ifstream stream(file);
+    std::ifstream stream(file, mode);
     return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
 }
 
+static std::uint64_t readLittleEndian(const char* data)
+{
+    std::uint64_t value{};
+    for (std::size_t i = 0; i < sizeof(value); ++i) {
+        value |= std::uint64_t{static_cast<unsigned char>(data[i])} << (8 * i);
+    }
+
+    return value;
+}
+
+static void writeLittleEndian(char* data, std::uint64_t value)
+{
+    for (std::size_t i = 0; i < sizeof(value); ++i) {
+        data[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+static std::uint64_t rotateLeft(std::uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Returns SipHash-2-4 of data, compiled templates are signed with it.
+// Only processes that know the key can create files that pass the check
+static std::uint64_t getSignature(const CacheKey& key, const char* data, std::size_t size)
+{
+    std::uint64_t v0{0x736f6d6570736575ull ^ key[0]};
+    std::uint64_t v1{0x646f72616e646f6dull ^ key[1]};
+    std::uint64_t v2{0x6c7967656e657261ull ^ key[0]};
+    std::uint64_t v3{0x7465646279746573ull ^ key[1]};
+
+    auto round = [&]() {
+        v0 += v1;
+        v1 = rotateLeft(v1, 13) ^ v0;
+        v0 = rotateLeft(v0, 32);
+        v2 += v3;
+        v3 = rotateLeft(v3, 16) ^ v2;
+        v0 += v3;
+        v3 = rotateLeft(v3, 21) ^ v0;
+        v2 += v1;
+        v1 = rotateLeft(v1, 17) ^ v2;
+        v2 = rotateLeft(v2, 32);
+    };
+
+    auto compress = [&](std::uint64_t word) {
+        v3 ^= word;
+        round();
+        round();
+        v0 ^= word;
+    };
+
+    std::size_t offset{};
+    for (; offset + sizeof(std::uint64_t) <= size; offset += sizeof(std::uint64_t)) {
+        compress(readLittleEndian(data + offset));
+    }
+
+    // Last word holds remaining bytes and lowest byte of data size
+    std::uint64_t last{static_cast<std::uint64_t>(size & 0xff) << 56};
+    for (std::size_t i = 0; offset + i < size; ++i) {
+        last |= std::uint64_t{static_cast<unsigned char>(data[offset + i])} << (8 * i);
+    }
+
+    compress(last);
+
+    v2 ^= 0xff;
+    for (int i = 0; i < 4; ++i) {
+        round();
+    }
+
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// Returns name of compiled template file: FNV-1a hash of template code and Lua version
+static std::string getCompiledTemplateName(const std::string& code)
+{
+    std::uint64_t hash{0xcbf29ce484222325ull};
+
+    auto add = [&hash](const void* data, std::size_t size) {
+        const auto bytes{static_cast<const unsigned char*>(data)};
+
+        for (std::size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+    };
+
+    const int luaVersion{LUA_VERSION_RELEASE_NUM};
+    add(&luaVersion, sizeof(luaVersion));
+    add(code.data(), code.size());
+
+    char name[64]{};
+    std::snprintf(name, sizeof(name), "%016llx-%zu.luac", static_cast<unsigned long long>(hash),
+                  code.size());
+    return name;
+}
+
+// Reads key of compiled template signatures from the cache folder, creates it if missing
+static bool readCacheKey(const std::filesystem::path& keyPath, CacheKey& key)
+{
+    std::string data{readFile(keyPath, std::ios::in | std::ios::binary)};
+
+    if (data.size() != sizeof(CacheKey)) {
+        std::random_device randomDevice;
+
+        data.resize(sizeof(CacheKey));
+        for (auto& byte : data) {
+            byte = static_cast<char>(randomDevice() & 0xff);
+        }
+
+        // Other process could create its key at the same time, use the one that was kept
+        replaceFile(keyPath, data);
+        data = readFile(keyPath, std::ios::in | std::ios::binary);
+
+        if (data.size() != sizeof(CacheKey)) {
+            return false;
+        }
+    }
+
+    key[0] = readLittleEndian(data.data());
+    key[1] = readLittleEndian(data.data() + sizeof(std::uint64_t));
+    return true;
+}
+
+static int writeChunk(lua_State*, const void* data, std::size_t size, void* userData)
+{
+    auto bytecode{static_cast<std::string*>(userData)};
+    bytecode->append(static_cast<const char*>(data), size);
+    return 0;
+}
+
+// Saves compiled chunk on top of the stack, failures are ignored since cache is optional.
+// Bytecode is preceded by its signature
+static void writeCompiledTemplate(lua_State* state, const std::filesystem::path& compiledPath)
+{
+    std::string contents(signatureSize, '\0');
+    // Keep debug information so errors still point to template lines
+    if (lua_dump(state, writeChunk, &contents, 0) != 0) {
+        return;
+    }
+
+    const auto signature{getSignature(templateCacheKey, contents.data() + signatureSize,
+                                      contents.size() - signatureSize)};
+    writeLittleEndian(contents.data(), signature);
+
+    replaceFile(compiledPath, contents);
+}
+
+// Pushes compiled template chunk on the stack.
+// Returns false if there is no compiled template or its signature is wrong.
+// Lua does not verify bytecode, so only files signed with our key are loaded
+static bool loadCompiledTemplate(const std::filesystem::path& compiledPath,
+                                 const std::string& chunkName,
+                                 lua_State* state)
+{
+    const std::string contents{readFile(compiledPath, std::ios::in | std::ios::binary)};
+    if (contents.size() <= signatureSize) {
+        return false;
+    }
+
+    const char* bytecode{contents.data() + signatureSize};
+    const std::size_t bytecodeSize{contents.size() - signatureSize};
+
+    if (readLittleEndian(contents.data())
+        != getSignature(templateCacheKey, bytecode, bytecodeSize)) {
+        return false;
+    }
+
+    if (luaL_loadbufferx(state, bytecode, bytecodeSize, chunkName.c_str(), "b") != LUA_OK) {
+        // Incompatible, compile template again
+        lua_pop(state, 1);
+        return false;
+    }
+
+    return true;
+}
+
+// Limits instructions and memory of template script while alive.
+// Limits are taken from generator settings and setTemplateMemoryLimit()
+class ScriptBudget
+{
+public:
+    ScriptBudget(lua_State* state)
+        : state{state}
+    {
+        const auto& settings{getGeneratorSettings()};
+        instructionLimit = std::uint64_t{settings.templateInstructionLimit} * 1000000u;
+        memoryLimit = std::size_t{settings.templateMemoryLimit} * 1024u * 1024u;
+
+        // State can have its own memory limit, the smaller one is used
+        if (lua_rawgetp(state, LUA_REGISTRYINDEX, &memoryLimitKey) == LUA_TNUMBER) {
+            const auto stateLimit{static_cast<std::size_t>(lua_tointeger(state, -1))};
+
+            if (stateLimit && (!memoryLimit || stateLimit < memoryLimit)) {
+                memoryLimit = stateLimit;
+            }
+        }
+
+        lua_pop(state, 1);
+
+        // Hook and allocator find budget in registry
+        lua_pushlightuserdata(state, this);
+        lua_rawsetp(state, LUA_REGISTRYINDEX, &registryKey);
+
+        if (instructionLimit) {
+            lua_sethook(state, countInstructions, LUA_MASKCOUNT, hookStep);
+        }
+
+        if (memoryLimit) {
+            allocator = lua_getallocf(state, &allocatorData);
+            lua_setallocf(state, allocate, this);
+        }
+    }
+
+    ~ScriptBudget()
+    {
+        if (instructionLimit) {
+            lua_sethook(state, nullptr, 0, 0);
+        }
+
+        if (memoryLimit) {
+            lua_setallocf(state, allocator, allocatorData);
+        }
+
+        lua_pushnil(state);
+        lua_rawsetp(state, LUA_REGISTRYINDEX, &registryKey);
+    }
+
+    ScriptBudget(const ScriptBudget&) = delete;
+    ScriptBudget& operator=(const ScriptBudget&) = delete;
+
+    // Registry key of memory limit set by setTemplateMemoryLimit()
+    static const char memoryLimitKey;
+
+    // Throws TemplateLimitException if script was stopped by one of the limits
+    void check() const
+    {
+        if (instructionsExceeded) {
+            throw TemplateLimitException("Template exceeded limit of "
+                                         + std::to_string(instructionLimit) + " instructions");
+        }
+
+        if (memoryExceeded) {
+            throw TemplateLimitException("Template exceeded memory limit of "
+                                         + std::to_string(memoryLimit) + " bytes");
+        }
+    }
+
+private:
+    static constexpr int hookStep{10000};
+    static const char registryKey;
+
+    static void countInstructions(lua_State* state, lua_Debug*)
+    {
+        lua_rawgetp(state, LUA_REGISTRYINDEX, &registryKey);
+        auto budget{static_cast<ScriptBudget*>(lua_touserdata(state, -1))};
+        lua_pop(state, 1);
+
+        budget->instructions += hookStep;
+        if (budget->instructions > budget->instructionLimit) {
+            budget->instructionsExceeded = true;
+            // Fail on each instruction from now on, so script can not recover with pcall
+            lua_sethook(state, countInstructions, LUA_MASKCOUNT, 1);
+            luaL_error(state, "template exceeded instruction limit");
+        }
+    }
+
+    static void* allocate(void* data, void* block, std::size_t oldSize, std::size_t newSize)
+    {
+        auto budget{static_cast<ScriptBudget*>(data)};
+        // Size of a new block is a Lua object type, not a size
+        const std::size_t currentSize{block ? oldSize : 0};
+
+        // Lua expects shrinking to always succeed, limit only applies to growth
+        if (newSize > currentSize) {
+            if (budget->allocated + (newSize - currentSize) > budget->memoryLimit) {
+                budget->memoryExceeded = true;
+                return nullptr;
+            }
+        }
+
+        void* result{budget->allocator(budget->allocatorData, block, oldSize, newSize)};
+        if (result || !newSize) {
+            if (newSize >= currentSize) {
+                budget->allocated += newSize - currentSize;
+            } else {
+                budget->allocated -= std::min(budget->allocated, currentSize - newSize);
+            }
+        }
+
+        return result;
+    }
+
+    lua_State* state;
+    lua_Alloc allocator{};
+    void* allocatorData{};
+    std::uint64_t instructionLimit{};
+    std::uint64_t instructions{};
+    std::size_t memoryLimit{};
+    // Bytes allocated since budget was created, blocks freed do not make it negative
+    std::size_t allocated{};
+    bool instructionsExceeded{};
+    bool memoryExceeded{};
+};
+
+const char ScriptBudget::registryKey{};
+const char ScriptBudget::memoryLimitKey{};
+
+// Pushes template chunk on the stack, compiled one is taken from cache when possible
+static void loadTemplate(const std::filesystem::path& templatePath, lua_State* state)
+{
+    const std::string code{readFile(templatePath)};
+    const std::string chunkName{"@" + templatePath.filename().string()};
+
+    std::filesystem::path compiledPath;
+    if (!templateCacheFolder.empty()) {
+        compiledPath = templateCacheFolder / getCompiledTemplateName(code);
+
+        if (loadCompiledTemplate(compiledPath, chunkName, state)) {
+            return;
+        }
+    }
+
+    if (luaL_loadbufferx(state, code.data(), code.size(), chunkName.c_str(), nullptr) != LUA_OK) {
+        std::string error{lua_tostring(state, -1)};
+        lua_pop(state, 1);
+
+        throw TemplateException(error);
+    }
+
+    if (!compiledPath.empty()) {
+        writeCompiledTemplate(state, compiledPath);
+    }
+}
+
 void bindLuaApi(sol::state& lua)
 {
     lua.open_libraries(sol::lib::base, sol::lib::package, sol::lib::math, sol::lib::table,
@@ -212,31 +566,6 @@ static std::string readString(const sol::table& table, const char* name, const s
     return table.get_or(name, def);
 }
 
-static void readId(CMidgardID& id, const sol::table& table, const char* name)
-{
-    auto idString{readString(table, name, "g000000000")};
-    CMidgardID tmpId(idString.c_str());
-
-    if (tmpId != invalidId) {
-        id = tmpId;
-    }
-}
-
-template <typename T>
-static void readRandomValue(RandomValue<T>& value,
-                            const sol::table& table,
-                            T def,
-                            T min = std::numeric_limits<T>::min(),
-                            T max = std::numeric_limits<T>::max())
-{
-    value.min = readValue(table, "min", def, min, max);
-    value.max = readValue(table, "max", def, min, max);
-
-    if (value.min > value.max) {
-        std::swap(value.min, value.max);
-    }
-}
-
 static void readStringSet(std::set<CMidgardID>& ids, const StringSet& stringSet)
 {
     for (const auto& string : stringSet) {
@@ -250,593 +579,468 @@ static void readStringSet(std::set<CMidgardID>& ids, const StringSet& stringSet)
     }
 }
 
-static void readAiPriority(AiPriority& value, const sol::table& table)
-{
-    const int min{static_cast<int>(AiPriority::Value::Priority0)};
-    const int max{static_cast<int>(AiPriority::Value::Priority6)};
-    const int dflt{(max - min) / 2};
-
-    int priority{readValue(table, "aiPriority", dflt, min, max)};
-    value.setPriority(static_cast<AiPriority::Value>(priority));
-}
-
-static void readMines(ZoneOptions& options, const sol::table& mines)
-{
-    auto gold = readValue(mines, "gold", 0, 0);
-    if (gold) {
-        options.mines[ResourceType::Gold] = gold;
-    }
-
-    auto lifeMana = readValue(mines, "lifeMana", 0, 0);
-    if (lifeMana) {
-        options.mines[ResourceType::LifeMana] = lifeMana;
-    }
-
-    auto deathMana = readValue(mines, "deathMana", 0, 0);
-    if (deathMana) {
-        options.mines[ResourceType::DeathMana] = deathMana;
-    }
-
-    auto infernalMana = readValue(mines, "infernalMana", 0, 0);
-    if (infernalMana) {
-        options.mines[ResourceType::InfernalMana] = infernalMana;
-    }
-
-    auto runicMana = readValue(mines, "runicMana", 0, 0);
-    if (runicMana) {
-        options.mines[ResourceType::RunicMana] = runicMana;
-    }
-
-    auto groveMana = readValue(mines, "groveMana", 0, 0);
-    if (groveMana) {
-        options.mines[ResourceType::GroveMana] = groveMana;
-    }
-}
-
-static void readRequiredItem(RequiredItemInfo& item, const sol::table& table)
-{
-    readId(item.itemId, table, "id");
-    readRandomValue<std::uint8_t>(item.amount, table, 1, 0);
-}
-
-static void readLoot(LootInfo& loot, const sol::table& table)
-{
-    auto itemTypes = table.get<sol::optional<decltype(loot.itemTypes)>>("itemTypes");
-    if (itemTypes) {
-        loot.itemTypes = itemTypes.value();
-    }
-
-    auto value = table.get<OptionalTable>("value");
-    if (value.has_value()) {
-        readRandomValue<std::uint32_t>(loot.value, value.value(), 0, 0);
-    }
-
-    auto itemValue = table.get<OptionalTable>("itemValue");
-    if (itemValue.has_value()) {
-        readRandomValue<std::uint32_t>(loot.itemValue, itemValue.value(), 0, 0);
-    }
-
-    auto items = table.get<OptionalTableArray>("items");
-    if (items.has_value()) {
-        loot.requiredItems.reserve(items.value().size());
-
-        for (const auto& item : items.value()) {
-            RequiredItemInfo info{};
-            readRequiredItem(info, item);
-
-            loot.requiredItems.push_back(info);
-        }
-    }
-}
-
-static void readGroup(GroupInfo& group, const sol::table& table)
-{
-    auto subraceTypes = table.get<sol::optional<decltype(group.subraceTypes)>>("subraceTypes");
-    if (subraceTypes.has_value()) {
-        group.subraceTypes = subraceTypes.value();
-    }
-
-    auto value = table.get<OptionalTable>("value");
-    if (value.has_value()) {
-        readRandomValue<std::uint32_t>(group.value, value.value(), 0, 0);
-    }
-
-    auto loot = table.get<OptionalTable>("loot");
-    if (loot.has_value()) {
-        readLoot(group.loot, loot.value());
-    }
-
-    group.owner = table.get_or("owner", RaceType::Neutral);
-    group.order = table.get_or("order", OrderType::Stand);
-    group.name = readString(table, "name", "");
-    auto units = table.get<sol::optional<StringSet>>("leaderIds");
-    if (units.has_value()) {
-        readStringSet(group.leaderIds, units.value());
-    }
-    auto modifiers = table.get<sol::optional<std::vector<std::string>>>("leaderModifiers");
-    if (modifiers.has_value()) {
-        for (const auto& modifier : modifiers.value()) {
-            CMidgardID modifierId(modifier.c_str());
-
-            if (modifierId == invalidId || modifierId == emptyId) {
-                continue;
-            }
-
-            group.leaderModifiers.push_back(modifierId);
-        }
-    }
-    readAiPriority(group.aiPriority, table);
-}
-
-static void readCity(CityInfo& city, const sol::table& table)
-{
-    auto garrison = table.get<OptionalTable>("garrison");
-    if (garrison.has_value()) {
-        readGroup(city.garrison, garrison.value());
-    }
-
-    auto stack = table.get<OptionalTable>("stack");
-    if (stack.has_value()) {
-        readGroup(city.stack, stack.value());
-    }
-
-    city.owner = table.get_or("owner", RaceType::Neutral);
-    city.tier = readValue(table, "tier", 1, 1, 5);
-    city.name = readString(table, "name", "");
-    city.gapMask = readValue(table, "gapMask", 0, 0, 15);
-    readAiPriority(city.aiPriority, table);
-}
-
-static void readCities(std::vector<CityInfo>& cities, const std::vector<sol::table>& tables)
-{
-    cities.reserve(tables.size());
-
-    for (auto& table : tables) {
-        CityInfo info{};
-        readCity(info, table);
-
-        cities.push_back(info);
-    }
-}
-
-static void readCapital(CapitalInfo& capital, const sol::table& table)
-{
-    auto garrison = table.get<OptionalTable>("garrison");
-    if (garrison.has_value()) {
-        readGroup(capital.garrison, garrison.value());
-    }
-
-    auto spells = table.get<sol::optional<std::set<std::string>>>("spells");
-    if (spells.has_value()) {
-        for (const auto& spell : spells.value()) {
-            CMidgardID spellId(spell.c_str());
-
-            if (spellId == invalidId || spellId == emptyId) {
-                continue;
-            }
-
-            capital.spells.insert(spellId);
-        }
-    }
-
-    auto buildings = table.get<sol::optional<std::set<std::string>>>("buildings");
-    if (buildings.has_value()) {
-        for (const auto& b : buildings.value()) {
-            CMidgardID buildingId(b.c_str());
-            if (buildingId == invalidId || buildingId == emptyId) {
-                continue;
-            }
-            capital.buildings.insert(buildingId);
-        }
-    }
-
-    capital.name = readString(table, "name", "");
-    capital.gapMask = readValue(table, "gapMask", 0, 0, 15);
-    capital.guardian = readValue(table, "guardian", true);
-    readAiPriority(capital.aiPriority, table);
-}
-
-static void readRuin(RuinInfo& ruin, const sol::table& table)
-{
-    auto guard = table.get<OptionalTable>("guard");
-    if (guard.has_value()) {
-        readGroup(ruin.guard, guard.value());
-    }
-
-    auto gold = table.get<OptionalTable>("gold");
-    if (gold.has_value()) {
-        readRandomValue<std::uint16_t>(ruin.gold, gold.value(), 0, 0, 9999);
-    }
-
-    auto loot = table.get<OptionalTable>("loot");
-    if (loot.has_value()) {
-        readLoot(ruin.loot, loot.value());
-    }
-
-    ruin.name = readString(table, "name", "");
-    readAiPriority(ruin.aiPriority, table);
-}
-
-static void readRuins(std::vector<RuinInfo>& ruins, const std::vector<sol::table>& tables)
-{
-    ruins.reserve(tables.size());
-
-    for (auto& table : tables) {
-        RuinInfo info{};
-        readRuin(info, table);
-
-        ruins.push_back(info);
-    }
-}
-
-static void readMerchant(MerchantInfo& merchant, const sol::table& table)
-{
-    auto loot = table.get<OptionalTable>("goods");
-    if (loot.has_value()) {
-        readLoot(merchant.items, loot.value());
-    }
-
-    auto guard = table.get<OptionalTable>("guard");
-    if (guard.has_value()) {
-        readGroup(merchant.guard, guard.value());
-    }
-
-    merchant.name = readString(table, "name", "");
-    merchant.description = readString(table, "description", "");
-    readAiPriority(merchant.aiPriority, table);
-}
-
-static void readMerchants(std::vector<MerchantInfo>& merchants,
-                          const std::vector<sol::table>& tables)
+static void readId(CMidgardID& id, LuaTableReader& reader)
 {
-    merchants.reserve(tables.size());
-
-    for (const auto& table : tables) {
-        MerchantInfo info{};
-        readMerchant(info, table);
-
-        merchants.push_back(info);
-    }
-}
-
-static void readMage(MageInfo& mage, const sol::table& table)
-{
-    auto guard = table.get<OptionalTable>("guard");
-    if (guard.has_value()) {
-        readGroup(mage.guard, guard.value());
-    }
-
-    auto spellTypes = table.get<sol::optional<decltype(mage.spellTypes)>>("spellTypes");
-    if (spellTypes.has_value()) {
-        mage.spellTypes = spellTypes.value();
-    }
-
-    auto value = table.get<OptionalTable>("value");
-    if (value.has_value()) {
-        readRandomValue<std::uint32_t>(mage.value, value.value(), 0, 0);
-    }
-
-    auto spellLevels = table.get<OptionalTable>("spellLevel");
-    if (spellLevels.has_value()) {
-        readRandomValue<std::uint8_t>(mage.spellLevels, spellLevels.value(), 1, 1, 5);
-    }
-
-    auto spells = table.get<sol::optional<std::set<std::string>>>("spells");
-    if (spells.has_value()) {
-        for (const auto& spell : spells.value()) {
-            CMidgardID spellId(spell.c_str());
-
-            if (spellId == invalidId || spellId == emptyId) {
-                continue;
-            }
+    auto idString{reader.readString("g000000000")};
+    CMidgardID tmpId(idString.c_str());
 
-            mage.requiredSpells.insert(spellId);
-        }
+    if (tmpId != invalidId) {
+        id = tmpId;
     }
-
-    mage.name = readString(table, "name", "");
-    mage.description = readString(table, "description", "");
-    readAiPriority(mage.aiPriority, table);
 }
 
-static void readMages(std::vector<MageInfo>& mages, const std::vector<sol::table>& tables)
+static void readAiPriority(AiPriority& value, LuaTableReader& reader)
 {
-    mages.reserve(tables.size());
-
-    for (const auto& table : tables) {
-        MageInfo info{};
-        readMage(info, table);
+    const int min{static_cast<int>(AiPriority::Value::Priority0)};
+    const int max{static_cast<int>(AiPriority::Value::Priority6)};
+    const int dflt{(max - min) / 2};
 
-        mages.push_back(info);
-    }
+    int priority{reader.readInteger(dflt, min, max)};
+    value.setPriority(static_cast<AiPriority::Value>(priority));
 }
 
-static void readMercenaryUnits(std::vector<MercenaryUnitInfo>& mercenaryUnits,
-                               const std::vector<sol::table>& units)
+static void readMine(ZoneOptions& options, ResourceType resource, LuaTableReader& reader)
 {
-    for (const auto& unit : units) {
-        MercenaryUnitInfo info{};
-
-        // TODO: check if unit with specified id exists
-        readId(info.unitId, unit, "id");
-        // TODO: make sure minimal unit level is correct, use UnitInfo for this
-        info.level = readValue(unit, "level", 1, 1, 99);
-        info.unique = readValue(unit, "unique", false);
-
-        mercenaryUnits.push_back(info);
+    auto count = reader.readInteger(0, 0);
+    if (count) {
+        options.mines[resource] = count;
     }
 }
 
-static void readMercenary(MercenaryInfo& mercenary, const sol::table& table)
+// Fields of template contents tables.
+// Fields are read in order of declaration, so later fields can depend on earlier ones
+
+static const LuaField<ZoneOptions> minesFields[] = {
+    {"gold", [](LuaTableReader& reader, ZoneOptions& options) {
+         readMine(options, ResourceType::Gold, reader);
+     }},
+    {"lifeMana", [](LuaTableReader& reader, ZoneOptions& options) {
+         readMine(options, ResourceType::LifeMana, reader);
+     }},
+    {"deathMana", [](LuaTableReader& reader, ZoneOptions& options) {
+         readMine(options, ResourceType::DeathMana, reader);
+     }},
+    {"infernalMana", [](LuaTableReader& reader, ZoneOptions& options) {
+         readMine(options, ResourceType::InfernalMana, reader);
+     }},
+    {"runicMana", [](LuaTableReader& reader, ZoneOptions& options) {
+         readMine(options, ResourceType::RunicMana, reader);
+     }},
+    {"groveMana", [](LuaTableReader& reader, ZoneOptions& options) {
+         readMine(options, ResourceType::GroveMana, reader);
+     }},
+};
+
+static const LuaField<RequiredItemInfo> requiredItemFields[] = {
+    {"id", [](LuaTableReader& reader, RequiredItemInfo& item) { readId(item.itemId, reader); }},
+    // Amount is described by 'min' and 'max' fields of the item itself
+    {nullptr, [](LuaTableReader& reader, RequiredItemInfo& item) {
+         reader.readRandomValue<std::uint8_t>(item.amount, 1, 0);
+     }},
+};
+
+static const LuaField<LootInfo> lootFields[] = {
+    {"itemTypes", [](LuaTableReader& reader, LootInfo& loot) {
+         reader.readEnums(loot.itemTypes);
+     }},
+    {"value", [](LuaTableReader& reader, LootInfo& loot) {
+         reader.readRandomValue<std::uint32_t>(loot.value, 0, 0);
+     }},
+    {"itemValue", [](LuaTableReader& reader, LootInfo& loot) {
+         reader.readRandomValue<std::uint32_t>(loot.itemValue, 0, 0);
+     }},
+    {"items", [](LuaTableReader& reader, LootInfo& loot) {
+         reader.readObjects(loot.requiredItems, requiredItemFields);
+     }},
+};
+
+static const LuaField<GroupInfo> groupFields[] = {
+    {"subraceTypes", [](LuaTableReader& reader, GroupInfo& group) {
+         reader.readEnums(group.subraceTypes);
+     }},
+    {"value", [](LuaTableReader& reader, GroupInfo& group) {
+         reader.readRandomValue<std::uint32_t>(group.value, 0, 0);
+     }},
+    {"loot", [](LuaTableReader& reader, GroupInfo& group) {
+         reader.readObject(group.loot, lootFields);
+     }},
+    {"owner", [](LuaTableReader& reader, GroupInfo& group) {
+         group.owner = reader.readEnum(RaceType::Neutral);
+     }},
+    {"order", [](LuaTableReader& reader, GroupInfo& group) {
+         group.order = reader.readEnum(OrderType::Stand);
+     }},
+    {"name", [](LuaTableReader& reader, GroupInfo& group) { group.name = reader.readString(""); }},
+    {"leaderIds", [](LuaTableReader& reader, GroupInfo& group) {
+         reader.readIds(group.leaderIds);
+     }},
+    {"leaderModifiers", [](LuaTableReader& reader, GroupInfo& group) {
+         reader.readIds(group.leaderModifiers);
+     }},
+    {"aiPriority", [](LuaTableReader& reader, GroupInfo& group) {
+         readAiPriority(group.aiPriority, reader);
+     }},
+};
+
+static const LuaField<CityInfo> cityFields[] = {
+    {"garrison", [](LuaTableReader& reader, CityInfo& city) {
+         reader.readObject(city.garrison, groupFields);
+     }},
+    {"stack", [](LuaTableReader& reader, CityInfo& city) {
+         reader.readObject(city.stack, groupFields);
+     }},
+    {"owner", [](LuaTableReader& reader, CityInfo& city) {
+         city.owner = reader.readEnum(RaceType::Neutral);
+     }},
+    {"tier", [](LuaTableReader& reader, CityInfo& city) { city.tier = reader.readInteger(1, 1, 5); }},
+    {"name", [](LuaTableReader& reader, CityInfo& city) { city.name = reader.readString(""); }},
+    {"gapMask", [](LuaTableReader& reader, CityInfo& city) {
+         city.gapMask = reader.readInteger(0, 0, 15);
+     }},
+    {"aiPriority", [](LuaTableReader& reader, CityInfo& city) {
+         readAiPriority(city.aiPriority, reader);
+     }},
+};
+
+static const LuaField<CapitalInfo> capitalFields[] = {
+    {"garrison", [](LuaTableReader& reader, CapitalInfo& capital) {
+         reader.readObject(capital.garrison, groupFields);
+     }},
+    {"spells", [](LuaTableReader& reader, CapitalInfo& capital) {
+         reader.readIds(capital.spells);
+     }},
+    {"buildings", [](LuaTableReader& reader, CapitalInfo& capital) {
+         reader.readIds(capital.buildings);
+     }},
+    {"name", [](LuaTableReader& reader, CapitalInfo& capital) {
+         capital.name = reader.readString("");
+     }},
+    {"gapMask", [](LuaTableReader& reader, CapitalInfo& capital) {
+         capital.gapMask = reader.readInteger(0, 0, 15);
+     }},
+    {"guardian", [](LuaTableReader& reader, CapitalInfo& capital) {
+         capital.guardian = reader.readBoolean(true);
+     }},
+    {"aiPriority", [](LuaTableReader& reader, CapitalInfo& capital) {
+         readAiPriority(capital.aiPriority, reader);
+     }},
+};
+
+static const LuaField<RuinInfo> ruinFields[] = {
+    {"guard", [](LuaTableReader& reader, RuinInfo& ruin) {
+         reader.readObject(ruin.guard, groupFields);
+     }},
+    {"gold", [](LuaTableReader& reader, RuinInfo& ruin) {
+         reader.readRandomValue<std::uint16_t>(ruin.gold, 0, 0, 9999);
+     }},
+    {"loot", [](LuaTableReader& reader, RuinInfo& ruin) {
+         reader.readObject(ruin.loot, lootFields);
+     }},
+    {"name", [](LuaTableReader& reader, RuinInfo& ruin) { ruin.name = reader.readString(""); }},
+    {"aiPriority", [](LuaTableReader& reader, RuinInfo& ruin) {
+         readAiPriority(ruin.aiPriority, reader);
+     }},
+};
+
+static const LuaField<MerchantInfo> merchantFields[] = {
+    {"goods", [](LuaTableReader& reader, MerchantInfo& merchant) {
+         reader.readObject(merchant.items, lootFields);
+     }},
+    {"guard", [](LuaTableReader& reader, MerchantInfo& merchant) {
+         reader.readObject(merchant.guard, groupFields);
+     }},
+    {"name", [](LuaTableReader& reader, MerchantInfo& merchant) {
+         merchant.name = reader.readString("");
+     }},
+    {"description", [](LuaTableReader& reader, MerchantInfo& merchant) {
+         merchant.description = reader.readString("");
+     }},
+    {"aiPriority", [](LuaTableReader& reader, MerchantInfo& merchant) {
+         readAiPriority(merchant.aiPriority, reader);
+     }},
+};
+
+static const LuaField<MageInfo> mageFields[] = {
+    {"guard", [](LuaTableReader& reader, MageInfo& mage) {
+         reader.readObject(mage.guard, groupFields);
+     }},
+    {"spellTypes", [](LuaTableReader& reader, MageInfo& mage) {
+         reader.readEnums(mage.spellTypes);
+     }},
+    {"value", [](LuaTableReader& reader, MageInfo& mage) {
+         reader.readRandomValue<std::uint32_t>(mage.value, 0, 0);
+     }},
+    {"spellLevel", [](LuaTableReader& reader, MageInfo& mage) {
+         reader.readRandomValue<std::uint8_t>(mage.spellLevels, 1, 1, 5);
+     }},
+    {"spells", [](LuaTableReader& reader, MageInfo& mage) {
+         reader.readIds(mage.requiredSpells);
+     }},
+    {"name", [](LuaTableReader& reader, MageInfo& mage) { mage.name = reader.readString(""); }},
+    {"description", [](LuaTableReader& reader, MageInfo& mage) {
+         mage.description = reader.readString("");
+     }},
+    {"aiPriority", [](LuaTableReader& reader, MageInfo& mage) {
+         readAiPriority(mage.aiPriority, reader);
+     }},
+};
+
+static const LuaField<MercenaryUnitInfo> mercenaryUnitFields[] = {
+    // TODO: check if unit with specified id exists
+    {"id", [](LuaTableReader& reader, MercenaryUnitInfo& unit) { readId(unit.unitId, reader); }},
+    // TODO: make sure minimal unit level is correct, use UnitInfo for this
+    {"level", [](LuaTableReader& reader, MercenaryUnitInfo& unit) {
+         unit.level = reader.readInteger(1, 1, 99);
+     }},
+    {"unique", [](LuaTableReader& reader, MercenaryUnitInfo& unit) {
+         unit.unique = reader.readBoolean(false);
+     }},
+};
+
+static const LuaField<MercenaryInfo> mercenaryFields[] = {
+    {"subraceTypes", [](LuaTableReader& reader, MercenaryInfo& mercenary) {
+         reader.readEnums(mercenary.subraceTypes);
+     }},
+    {"value", [](LuaTableReader& reader, MercenaryInfo& mercenary) {
+         reader.readRandomValue<std::uint32_t>(mercenary.value, 0, 0);
+     }},
+    {"enrollValue", [](LuaTableReader& reader, MercenaryInfo& mercenary) {
+         reader.readRandomValue<std::uint32_t>(mercenary.enrollValue, 0, 0);
+     }},
+    {"units", [](LuaTableReader& reader, MercenaryInfo& mercenary) {
+         reader.readObjects(mercenary.requiredUnits, mercenaryUnitFields);
+     }},
+    {"guard", [](LuaTableReader& reader, MercenaryInfo& mercenary) {
+         reader.readObject(mercenary.guard, groupFields);
+     }},
+    {"name", [](LuaTableReader& reader, MercenaryInfo& mercenary) {
+         mercenary.name = reader.readString("");
+     }},
+    {"description", [](LuaTableReader& reader, MercenaryInfo& mercenary) {
+         mercenary.description = reader.readString("");
+     }},
+    {"aiPriority", [](LuaTableReader& reader, MercenaryInfo& mercenary) {
+         readAiPriority(mercenary.aiPriority, reader);
+     }},
+};
+
+// Element of resource market 'stock' array
+struct ResourceMarketStockEntry
 {
-    auto subraceTypes = table.get<sol::optional<decltype(mercenary.subraceTypes)>>("subraceTypes");
-    if (subraceTypes.has_value()) {
-        mercenary.subraceTypes = subraceTypes.value();
-    }
-
-    auto value = table.get<OptionalTable>("value");
-    if (value.has_value()) {
-        readRandomValue<std::uint32_t>(mercenary.value, value.value(), 0, 0);
-    }
-
-    auto enrollValue = table.get<OptionalTable>("enrollValue");
-    if (enrollValue.has_value()) {
-        readRandomValue<std::uint32_t>(mercenary.enrollValue, enrollValue.value(), 0, 0);
-    }
-
-    auto units = table.get<OptionalTableArray>("units");
-    if (units.has_value()) {
-        readMercenaryUnits(mercenary.requiredUnits, units.value());
-    }
-
-    auto guard = table.get<OptionalTable>("guard");
-    if (guard.has_value()) {
-        readGroup(mercenary.guard, guard.value());
-    }
-
-    mercenary.name = readString(table, "name", "");
-    mercenary.description = readString(table, "description", "");
-    readAiPriority(mercenary.aiPriority, table);
-}
-
-static void readMercenaries(std::vector<MercenaryInfo>& mercenaries,
-                            const std::vector<sol::table>& tables)
-{
-    mercenaries.reserve(tables.size());
-
-    for (const auto& table : tables) {
-        MercenaryInfo info{};
-        readMercenary(info, table);
-
-        mercenaries.push_back(info);
-    }
-}
+    ResourceType resource{ResourceType::Gold};
+    ResourceMarketStock stock;
+};
+
+static const LuaField<ResourceMarketStockEntry> resourceMarketStockFields[] = {
+    {"resource", [](LuaTableReader& reader, ResourceMarketStockEntry& entry) {
+         entry.resource = reader.readRequiredEnum<ResourceType>();
+     }},
+    {"infinite", [](LuaTableReader& reader, ResourceMarketStockEntry& entry) {
+         entry.stock.infinite = reader.readBoolean(false);
+     }},
+    {"value", [](LuaTableReader& reader, ResourceMarketStockEntry& entry) {
+         if (!entry.stock.infinite) {
+             reader.readRandomValue<std::uint32_t>(entry.stock.amount, 0, 0);
+         }
+     }},
+};
 
 static void readResourceMarketStock(std::map<ResourceType, ResourceMarketStock>& stock,
-                                    const std::vector<sol::table>& resources)
-{
-    for (const auto& table : resources) {
-        const ResourceType resource = table.get<ResourceType>("resource");
-        if (contains(stock, resource)) {
-            // Ignore duplicates
-            continue;
-        }
-
-        ResourceMarketStock resourceStock{};
-        resourceStock.infinite = table.get_or("infinite", false);
-        if (!resourceStock.infinite) {
-            auto value = table.get<OptionalTable>("value");
-            if (value.has_value()) {
-                readRandomValue<std::uint32_t>(resourceStock.amount, value.value(), 0, 0);
-            }
-        }
-
-        stock[resource] = resourceStock;
-    }
-}
-
-static void readResourceMarket(ResourceMarketInfo& market, const sol::table& table)
-{
-    market.exchangeRates = readString(table, "exchangeRates", "");
-
-    auto stock = table.get<OptionalTableArray>("stock");
-    if (stock.has_value()) {
-        readResourceMarketStock(market.stock, stock.value());
-    }
-
-    auto guard = table.get<OptionalTable>("guard");
-    if (guard.has_value()) {
-        readGroup(market.guard, guard.value());
-    }
-
-    market.name = readString(table, "name", "");
-    market.description = readString(table, "description", "");
-    readAiPriority(market.aiPriority, table);
-}
-
-static void readResourceMarkets(std::vector<ResourceMarketInfo>& markets,
-                                const std::vector<sol::table>& tables)
-{
-    markets.reserve(tables.size());
-
-    for (const auto& table : tables) {
-        ResourceMarketInfo info{};
-        readResourceMarket(info, table);
-
-        markets.push_back(info);
-    }
-}
-
-static void readStacks(StacksInfo& stacks, const std::vector<sol::table>& tables)
-{
-    stacks.stackGroups.reserve(tables.size());
-
-    for (auto& table : tables) {
-        NeutralStacksInfo info{};
-
-        readGroup(info.stacks, table);
-        info.count = readValue(table, "count", 0, 0);
-        info.owner = table.get_or("owner", RaceType::Neutral);
-        info.order = table.get_or("order", OrderType::Stand);
-        info.name = readString(table, "name", "");
-        readAiPriority(info.aiPriority, table);
-        auto units = table.get<sol::optional<StringSet>>("leaderIds");
-        if (units.has_value()) {
-            readStringSet(info.leaderIds, units.value());
-        }
-        auto modifiers = table.get<sol::optional<std::vector<std::string>>>("leaderModifiers");
-        if (modifiers.has_value()) {
-            for (const auto& modifier : modifiers.value()) {
-                CMidgardID modifierId(modifier.c_str());
-
-                if (modifierId == invalidId || modifierId == emptyId) {
-                    continue;
-                }
-
-                info.leaderModifiers.push_back(modifierId);
-            }
-        }
-
-        stacks.stackGroups.push_back(info);
-    }
-}
-
-static void readBags(BagInfo& bagInfo, const sol::table& table)
-{
-    auto loot = table.get<OptionalTable>("loot");
-    if (loot.has_value()) {
-        readLoot(bagInfo.loot, loot.value());
-    }
-
-    bagInfo.count = readValue(table, "count", 0, 0);
-    readAiPriority(bagInfo.aiPriority, table);
-}
-
-static void readTrainers(std::vector<TrainerInfo>& trainers, const std::vector<sol::table>& tables)
-{
-    trainers.reserve(tables.size());
-
-    for (const auto& table : tables) {
-        TrainerInfo info{};
-
-        auto guard = table.get<OptionalTable>("guard");
-        if (guard.has_value()) {
-            readGroup(info.guard, guard.value());
-        }
-
-        info.name = readString(table, "name", "");
-        info.description = readString(table, "description", "");
-        readAiPriority(info.aiPriority, table);
-
-        trainers.push_back(info);
-    }
-}
-
-static std::shared_ptr<ZoneOptions> createZoneOptions(const sol::table& zone)
+                                    LuaTableReader& reader)
 {
-    auto options = std::make_shared<ZoneOptions>();
+    reader.forEachElement([&stock, &reader]() {
+        reader.expectTable();
 
-    options->id = readValue(zone, "id", -1, 0);
-    options->type = zone.get<TemplateZoneType>("type");
+        ResourceMarketStockEntry entry{};
+        reader.readObject(entry, resourceMarketStockFields);
 
-    if (options->type == TemplateZoneType::PlayerStart
-        || options->type == TemplateZoneType::AiStart) {
-        options->playerRace = zone.get<RaceType>("race");
-
-        auto capital = zone.get<OptionalTable>("capital");
-        if (capital.has_value()) {
-            readCapital(options->capital, capital.value());
+        if (contains(stock, entry.resource)) {
+            // Ignore duplicates
+            return;
         }
-    }
-
-    options->size = readValue(zone, "size", 1, 1);
-    options->borderType = zone.get_or("border", ZoneBorderType::Closed);
-    if (options->borderType == ZoneBorderType::SemiOpen) {
-        options->gapChance = readValue(zone, "gapChance", 50, 0, 100);
-    }
-
-    auto mines = zone.get<OptionalTable>("mines");
-    if (mines.has_value()) {
-        readMines(*options, mines.value());
-    }
-
-    auto cities = zone.get<OptionalTableArray>("towns");
-    if (cities.has_value()) {
-        readCities(options->neutralCities, cities.value());
-    }
-
-    auto ruins = zone.get<OptionalTableArray>("ruins");
-    if (ruins.has_value()) {
-        readRuins(options->ruins, ruins.value());
-    }
-
-    auto merchants = zone.get<OptionalTableArray>("merchants");
-    if (merchants.has_value()) {
-        readMerchants(options->merchants, merchants.value());
-    }
-
-    auto mages = zone.get<OptionalTableArray>("mages");
-    if (mages.has_value()) {
-        readMages(options->mages, mages.value());
-    }
-
-    auto mercenaries = zone.get<OptionalTableArray>("mercenaries");
-    if (mercenaries.has_value()) {
-        readMercenaries(options->mercenaries, mercenaries.value());
-    }
-
-    auto stacks = zone.get<OptionalTableArray>("stacks");
-    if (stacks.has_value()) {
-        readStacks(options->stacks, stacks.value());
-    }
-
-    auto bags = zone.get<OptionalTable>("bags");
-    if (bags.has_value()) {
-        readBags(options->bags, bags.value());
-    }
-
-    auto trainers = zone.get<OptionalTableArray>("trainers");
-    if (trainers.has_value()) {
-        readTrainers(options->trainers, trainers.value());
-    }
-
-    auto resourceMarkets = zone.get<OptionalTableArray>("resourceMarkets");
-    if (resourceMarkets.has_value()) {
-        readResourceMarkets(options->markets, resourceMarkets.value());
-    }
 
-    return options;
+        stock[entry.resource] = entry.stock;
+    });
 }
 
-static ZoneConnection createZoneConnection(const sol::table& table,
-                                           const MapTemplateContents::Zones& zones)
+static const LuaField<ResourceMarketInfo> resourceMarketFields[] = {
+    {"exchangeRates", [](LuaTableReader& reader, ResourceMarketInfo& market) {
+         market.exchangeRates = reader.readString("");
+     }},
+    {"stock", [](LuaTableReader& reader, ResourceMarketInfo& market) {
+         readResourceMarketStock(market.stock, reader);
+     }},
+    {"guard", [](LuaTableReader& reader, ResourceMarketInfo& market) {
+         reader.readObject(market.guard, groupFields);
+     }},
+    {"name", [](LuaTableReader& reader, ResourceMarketInfo& market) {
+         market.name = reader.readString("");
+     }},
+    {"description", [](LuaTableReader& reader, ResourceMarketInfo& market) {
+         market.description = reader.readString("");
+     }},
+    {"aiPriority", [](LuaTableReader& reader, ResourceMarketInfo& market) {
+         readAiPriority(market.aiPriority, reader);
+     }},
+};
+
+static const LuaField<NeutralStacksInfo> stacksFields[] = {
+    // Value and loot of entire group are described by the stacks table itself
+    {nullptr, [](LuaTableReader& reader, NeutralStacksInfo& info) {
+         reader.readObject(info.stacks, groupFields);
+     }},
+    {"count", [](LuaTableReader& reader, NeutralStacksInfo& info) {
+         info.count = reader.readInteger(0, 0);
+     }},
+    {"owner", [](LuaTableReader& reader, NeutralStacksInfo& info) {
+         info.owner = reader.readEnum(RaceType::Neutral);
+     }},
+    {"order", [](LuaTableReader& reader, NeutralStacksInfo& info) {
+         info.order = reader.readEnum(OrderType::Stand);
+     }},
+    {"name", [](LuaTableReader& reader, NeutralStacksInfo& info) {
+         info.name = reader.readString("");
+     }},
+    {"aiPriority", [](LuaTableReader& reader, NeutralStacksInfo& info) {
+         readAiPriority(info.aiPriority, reader);
+     }},
+    {"leaderIds", [](LuaTableReader& reader, NeutralStacksInfo& info) {
+         reader.readIds(info.leaderIds);
+     }},
+    {"leaderModifiers", [](LuaTableReader& reader, NeutralStacksInfo& info) {
+         reader.readIds(info.leaderModifiers);
+     }},
+};
+
+static const LuaField<BagInfo> bagFields[] = {
+    {"loot", [](LuaTableReader& reader, BagInfo& bags) {
+         reader.readObject(bags.loot, lootFields);
+     }},
+    {"count", [](LuaTableReader& reader, BagInfo& bags) { bags.count = reader.readInteger(0, 0); }},
+    {"aiPriority", [](LuaTableReader& reader, BagInfo& bags) {
+         readAiPriority(bags.aiPriority, reader);
+     }},
+};
+
+static const LuaField<TrainerInfo> trainerFields[] = {
+    {"guard", [](LuaTableReader& reader, TrainerInfo& trainer) {
+         reader.readObject(trainer.guard, groupFields);
+     }},
+    {"name", [](LuaTableReader& reader, TrainerInfo& trainer) {
+         trainer.name = reader.readString("");
+     }},
+    {"description", [](LuaTableReader& reader, TrainerInfo& trainer) {
+         trainer.description = reader.readString("");
+     }},
+    {"aiPriority", [](LuaTableReader& reader, TrainerInfo& trainer) {
+         readAiPriority(trainer.aiPriority, reader);
+     }},
+};
+
+static bool isStartingZone(const ZoneOptions& options)
 {
-    ZoneConnection connection;
-
-    connection.zoneFrom = readValue(table, "from", -1, 0);
-    connection.zoneTo = readValue(table, "to", -1, 0);
-
-    assert(zones.find(connection.zoneFrom) != zones.end());
-    assert(zones.find(connection.zoneTo) != zones.end());
-
-    auto guard = table.get<OptionalTable>("guard");
-    if (guard.has_value()) {
-        readGroup(connection.guard, guard.value());
-    }
-    connection.size = readValue(table, "size", 1, 0, 1);
-
-    return connection;
+    return options.type == TemplateZoneType::PlayerStart
+           || options.type == TemplateZoneType::AiStart;
 }
 
-static void readDiplomacyRelation(const sol::table& table, MapTemplateDiplomacy::Relation& relation)
+static const LuaField<ZoneOptions> zoneFields[] = {
+    {"id", [](LuaTableReader& reader, ZoneOptions& options) {
+         options.id = reader.readInteger(-1, 0);
+     }},
+    {"type", [](LuaTableReader& reader, ZoneOptions& options) {
+         options.type = reader.readRequiredEnum<TemplateZoneType>();
+     }},
+    {"race", [](LuaTableReader& reader, ZoneOptions& options) {
+         if (isStartingZone(options)) {
+             options.playerRace = reader.readRequiredEnum<RaceType>();
+         }
+     }},
+    {"capital", [](LuaTableReader& reader, ZoneOptions& options) {
+         if (isStartingZone(options)) {
+             reader.readObject(options.capital, capitalFields);
+         }
+     }},
+    {"size", [](LuaTableReader& reader, ZoneOptions& options) {
+         options.size = reader.readInteger(1, 1);
+     }},
+    {"border", [](LuaTableReader& reader, ZoneOptions& options) {
+         options.borderType = reader.readEnum(ZoneBorderType::Closed);
+     }},
+    {"gapChance", [](LuaTableReader& reader, ZoneOptions& options) {
+         if (options.borderType == ZoneBorderType::SemiOpen) {
+             options.gapChance = reader.readInteger(50, 0, 100);
+         }
+     }},
+    {"mines", [](LuaTableReader& reader, ZoneOptions& options) {
+         reader.readObject(options, minesFields);
+     }},
+    {"towns", [](LuaTableReader& reader, ZoneOptions& options) {
+         reader.readObjects(options.neutralCities, cityFields);
+     }},
+    {"ruins", [](LuaTableReader& reader, ZoneOptions& options) {
+         reader.readObjects(options.ruins, ruinFields);
+     }},
+    {"merchants", [](LuaTableReader& reader, ZoneOptions& options) {
+         reader.readObjects(options.merchants, merchantFields);
+     }},
+    {"mages", [](LuaTableReader& reader, ZoneOptions& options) {
+         reader.readObjects(options.mages, mageFields);
+     }},
+    {"mercenaries", [](LuaTableReader& reader, ZoneOptions& options) {
+         reader.readObjects(options.mercenaries, mercenaryFields);
+     }},
+    {"stacks", [](LuaTableReader& reader, ZoneOptions& options) {
+         reader.readObjects(options.stacks.stackGroups, stacksFields);
+     }},
+    {"bags", [](LuaTableReader& reader, ZoneOptions& options) {
+         reader.readObject(options.bags, bagFields);
+     }},
+    {"trainers", [](LuaTableReader& reader, ZoneOptions& options) {
+         reader.readObjects(options.trainers, trainerFields);
+     }},
+    {"resourceMarkets", [](LuaTableReader& reader, ZoneOptions& options) {
+         reader.readObjects(options.markets, resourceMarketFields);
+     }},
+};
+
+static const LuaField<ZoneConnection> connectionFields[] = {
+    {"from", [](LuaTableReader& reader, ZoneConnection& connection) {
+         connection.zoneFrom = reader.readInteger(-1, 0);
+     }},
+    {"to", [](LuaTableReader& reader, ZoneConnection& connection) {
+         connection.zoneTo = reader.readInteger(-1, 0);
+     }},
+    {"guard", [](LuaTableReader& reader, ZoneConnection& connection) {
+         reader.readObject(connection.guard, groupFields);
+     }},
+    {"size", [](LuaTableReader& reader, ZoneConnection& connection) {
+         connection.size = reader.readInteger(1, 0, 1);
+     }},
+};
+
+static const LuaField<MapTemplateDiplomacy::Relation> diplomacyRelationFields[] = {
+    {"raceA", [](LuaTableReader& reader, MapTemplateDiplomacy::Relation& relation) {
+         relation.raceA = reader.readRequiredEnum<RaceType>();
+     }},
+    {"raceB", [](LuaTableReader& reader, MapTemplateDiplomacy::Relation& relation) {
+         relation.raceB = reader.readRequiredEnum<RaceType>();
+     }},
+    {"relation", [](LuaTableReader& reader, MapTemplateDiplomacy::Relation& relation) {
+         relation.relation = reader.readInteger<std::uint8_t>(0u, 0u, 100u);
+     }},
+    {"alliance", [](LuaTableReader& reader, MapTemplateDiplomacy::Relation& relation) {
+         relation.alliance = reader.readBoolean(false);
+     }},
+    {"alwaysAtWar", [](LuaTableReader& reader, MapTemplateDiplomacy::Relation& relation) {
+         relation.alwaysAtWar = reader.readBoolean(false);
+     }},
+    {"permanentAlliance", [](LuaTableReader& reader, MapTemplateDiplomacy::Relation& relation) {
+         relation.permanentAlliance = reader.readBoolean(false);
+     }},
+};
+
+static void checkDiplomacyRelation(const MapTemplateDiplomacy::Relation& relation)
 {
-    relation.raceA = table.get<RaceType>("raceA");
-    relation.raceB = table.get<RaceType>("raceB");
-    relation.relation = readValue<std::uint8_t>(table, "relation", 0u, 0u, 100u);
-    relation.alliance = readValue(table, "alliance", false);
-    relation.alwaysAtWar = readValue(table, "alwaysAtWar", false);
-    relation.permanentAlliance = readValue(table, "permanentAlliance", false);
-
     if (relation.alliance && relation.alwaysAtWar) {
         throw TemplateException("Invalid template diplomacy relation between "
                                 + std::to_string((int)relation.raceA) + " and "
@@ -852,18 +1056,13 @@ static void readDiplomacyRelation(const sol::table& table, MapTemplateDiplomacy:
     }
 }
 
-static void readDiplomacy(const std::vector<sol::table>& tables, MapTemplateDiplomacy& diplomacy)
+static void checkDiplomacy(const MapTemplateDiplomacy& diplomacy)
 {
-    diplomacy.relations.reserve(tables.size());
-
-    for (const auto& table : tables) {
-        MapTemplateDiplomacy::Relation relation{};
-        readDiplomacyRelation(table, relation);
-
-        diplomacy.relations.push_back(relation);
+    const auto& relations{diplomacy.relations};
+    for (const auto& relation : relations) {
+        checkDiplomacyRelation(relation);
     }
 
-    const auto& relations{diplomacy.relations};
     const std::size_t total{relations.size()};
     for (std::size_t i = 0u; i < total; ++i) {
         for (std::size_t j = i + 1u; j < total; ++j) {
@@ -879,16 +1078,16 @@ static void readDiplomacy(const std::vector<sol::table>& tables, MapTemplateDipl
     }
 }
 
-static void readScenarioVariables(const std::vector<sol::table>& tables,
-    std::vector<MapTemplateScenarioVariables::ScenarioVariables>& scenarioVariables)
-{
-    for (const auto& table : tables) {
-        MapTemplateScenarioVariables::ScenarioVariables scenarioVariable{};
-        scenarioVariable.name = readString(table, "name", "");
-        scenarioVariable.value = readValue(table, "value", 0, -2147483647, 2147483647);
-        scenarioVariables.push_back(scenarioVariable);
-    }
-}
+using ScenarioVariable = MapTemplateScenarioVariables::ScenarioVariables;
+
+static const LuaField<ScenarioVariable> scenarioVariableFields[] = {
+    {"name", [](LuaTableReader& reader, ScenarioVariable& variable) {
+         variable.name = reader.readString("");
+     }},
+    {"value", [](LuaTableReader& reader, ScenarioVariable& variable) {
+         variable.value = reader.readInteger(0, -2147483647, 2147483647);
+     }},
+};
 
 static void readTemplateCustomParameters(std::vector<MapTemplateSettings::TemplateCustomParameter>& parameters,
                                          const std::vector<sol::table>& tables)
@@ -919,21 +1118,88 @@ static void readTemplateCustomParameters(std::vector<MapTemplateSettings::Templa
     }
 }
 
-static void readContents(MapTemplate& mapTemplate, const sol::table& contentsTable)
+static void readForbiddenIds(std::set<CMidgardID>& ids, LuaTableReader& reader)
 {
-    MapTemplateContents& contents = mapTemplate.contents;
-
-    std::vector<sol::table> zones = contentsTable.get<std::vector<sol::table>>("zones");
-    for (auto& table : zones) {
-        auto options{createZoneOptions(table)};
-        contents.zones[options->id] = options;
+    if (reader.isTable()) {
+        ids.clear();
+        reader.readIds(ids);
     }
+}
 
-    auto maxPlayers = readValue(contentsTable, "maxPlayers", 0, 0, 4);
-    if (maxPlayers > 0) {
-        mapTemplate.settings.maxPlayers = maxPlayers;
+static const LuaField<MapTemplate> contentsFields[] = {
+    {"zones", [](LuaTableReader& reader, MapTemplate& mapTemplate) {
+         reader.expectTable();
+         reader.forEachElement([&reader, &mapTemplate]() {
+             reader.expectTable();
+
+             auto options{std::make_shared<ZoneOptions>()};
+             reader.readObject(*options, zoneFields);
+             mapTemplate.contents.zones[options->id] = options;
+         });
+     }},
+    {"maxPlayers", [](LuaTableReader& reader, MapTemplate& mapTemplate) {
+         auto maxPlayers = reader.readInteger(0, 0, 4);
+         if (maxPlayers > 0) {
+             mapTemplate.settings.maxPlayers = maxPlayers;
+         }
+     }},
+    {"connections", [](LuaTableReader& reader, MapTemplate& mapTemplate) {
+         reader.expectTable();
+         reader.readObjects(mapTemplate.contents.connections, connectionFields);
+     }},
+    {"diplomacy", [](LuaTableReader& reader, MapTemplate& mapTemplate) {
+         reader.readObjects(mapTemplate.contents.diplomacy.relations, diplomacyRelationFields);
+     }},
+    {"scenarioVariables", [](LuaTableReader& reader, MapTemplate& mapTemplate) {
+         reader.readObjects(mapTemplate.contents.scenarioVariables.scenarioVariables,
+                            scenarioVariableFields);
+     }},
+    {"forbiddenUnits", [](LuaTableReader& reader, MapTemplate& mapTemplate) {
+         readForbiddenIds(mapTemplate.settings.forbiddenUnits, reader);
+     }},
+    {"forbiddenItems", [](LuaTableReader& reader, MapTemplate& mapTemplate) {
+         readForbiddenIds(mapTemplate.settings.forbiddenItems, reader);
+     }},
+    {"forbiddenSpells", [](LuaTableReader& reader, MapTemplate& mapTemplate) {
+         readForbiddenIds(mapTemplate.settings.forbiddenSpells, reader);
+     }},
+    {"roads", [](LuaTableReader& reader, MapTemplate& mapTemplate) {
+         auto roads = reader.readInteger(-1, -1, 100);
+         if (roads >= 0) {
+             mapTemplate.settings.roads = roads;
+         }
+     }},
+    {"forest", [](LuaTableReader& reader, MapTemplate& mapTemplate) {
+         auto forest = reader.readInteger(-1, -1, 100);
+         if (forest >= 0) {
+             mapTemplate.settings.forest = forest;
+         }
+     }},
+    {"startingGold", [](LuaTableReader& reader, MapTemplate& mapTemplate) {
+         auto startingGold = reader.readInteger(-1, -1, 9999);
+         if (startingGold >= 0) {
+             mapTemplate.settings.startingGold = startingGold;
+         }
+     }},
+    {"startingNativeMana", [](LuaTableReader& reader, MapTemplate& mapTemplate) {
+         auto startingNativeMana = reader.readInteger(-1, -1, 9999);
+         if (startingNativeMana >= 0) {
+             mapTemplate.settings.startingNativeMana = startingNativeMana;
+         }
+     }},
+};
+
+static void readContents(MapTemplate& mapTemplate, lua_State* state, int contentsIndex)
+{
+    {
+        LuaTableReader reader{state};
+
+        lua_pushvalue(state, contentsIndex);
+        reader.readObject(mapTemplate, contentsFields);
     }
 
+    MapTemplateContents& contents = mapTemplate.contents;
+
     const auto startingZones{
         std::count_if(contents.zones.begin(), contents.zones.end(), [](const auto& it) {
             auto& zoneOptions{it.second};
@@ -949,74 +1215,25 @@ static void readContents(MapTemplate& mapTemplate, const sol::table& contentsTab
                                 + " players allowed");
     }
 
-    std::vector<sol::table> connections = contentsTable.get<std::vector<sol::table>>("connections");
-    for (auto& table : connections) {
-        contents.connections.push_back(createZoneConnection(table, contents.zones));
-    }
-
     // Populate zone connections
     for (auto& connection : contents.connections) {
         const auto zoneFromId{connection.zoneFrom};
         const auto zoneToId{connection.zoneTo};
 
         auto zoneFrom = contents.zones.find(zoneFromId);
-        assert(zoneFrom != contents.zones.end());
-
         auto zoneTo = contents.zones.find(zoneToId);
-        assert(zoneTo != contents.zones.end());
+
+        if (zoneFrom == contents.zones.end() || zoneTo == contents.zones.end()) {
+            throw TemplateException("Invalid template contents: connection between zones "
+                                    + std::to_string(zoneFromId) + " and "
+                                    + std::to_string(zoneToId) + " refers to missing zone");
+        }
 
         zoneFrom->second->connections.push_back(zoneToId);
         zoneTo->second->connections.push_back(zoneFromId);
     }
 
-    auto diplomacyTable = contentsTable.get<OptionalTableArray>("diplomacy");
-    if (diplomacyTable.has_value()) {
-        readDiplomacy(diplomacyTable.value(), contents.diplomacy);
-    }
-
-    auto scenarioVariablesTable = contentsTable.get<OptionalTableArray>("scenarioVariables");
-    if (scenarioVariablesTable.has_value()) {
-        readScenarioVariables(scenarioVariablesTable.value(), contents.scenarioVariables.scenarioVariables);
-    }
-
-    auto units = contentsTable.get<sol::optional<StringSet>>("forbiddenUnits");
-    if (units.has_value()) {
-        mapTemplate.settings.forbiddenUnits.clear();
-        readStringSet(mapTemplate.settings.forbiddenUnits, units.value());
-    }
-
-    auto items = contentsTable.get<sol::optional<StringSet>>("forbiddenItems");
-    if (items.has_value()) {
-        mapTemplate.settings.forbiddenItems.clear();
-        readStringSet(mapTemplate.settings.forbiddenItems, items.value());
-    }
-
-    auto spells = contentsTable.get<sol::optional<StringSet>>("forbiddenSpells");
-    if (spells.has_value()) {
-        mapTemplate.settings.forbiddenSpells.clear();
-        readStringSet(mapTemplate.settings.forbiddenSpells, spells.value());
-    }
-
-    auto roads = readValue(contentsTable, "roads", -1, -1, 100);
-    if (roads >= 0) {
-        mapTemplate.settings.roads = roads;
-    }
-
-    auto forest = readValue(contentsTable, "forest", -1, -1, 100);
-    if (forest >= 0) {
-        mapTemplate.settings.forest = forest;
-    }
-
-    auto startingGold = readValue(contentsTable, "startingGold", -1, -1, 9999);
-    if (startingGold >= 0) {
-        mapTemplate.settings.startingGold = startingGold;
-    }
-
-    auto startingNativeMana = readValue(contentsTable, "startingNativeMana", -1, -1, 9999);
-    if (startingNativeMana >= 0) {
-        mapTemplate.settings.startingNativeMana = startingNativeMana;
-    }
-    
+    checkDiplomacy(contents.diplomacy);
 }
 
 static void readSettings(MapTemplateSettings& settings, const sol::state& lua)
@@ -1054,6 +1271,9 @@ static void readSettings(MapTemplateSettings& settings, const sol::state& lua)
     settings.forest = readValue(table, "forest", 0, 0, 100);
 
     settings.iterations = readValue(table, "iterations", 0, 0, 1000000);
+    settings.placementRuns = readValue(table, "placementRuns", 1, 1, 64);
+    settings.convergenceWindow = readValue(table, "convergenceWindow", 0, 0, 1000000);
+    settings.convergenceThreshold = readValue(table, "convergenceThreshold", 1.0f, 0.0f, 100.0f);
 
     auto parameters = table.get<OptionalTableArray>("customParameters");
     if (parameters.has_value()) {
@@ -1076,18 +1296,52 @@ static void readSettings(MapTemplateSettings& settings, const sol::state& lua)
     }
 }
 
+bool setTemplateCacheFolder(const std::filesystem::path& folder)
+{
+    templateCacheFolder.clear();
+
+    if (folder.empty()) {
+        return true;
+    }
+
+    if (!createPrivateFolder(folder) || !readCacheKey(folder / "key", templateCacheKey)) {
+        return false;
+    }
+
+    templateCacheFolder = folder;
+    return true;
+}
+
+void setTemplateMemoryLimit(sol::state& lua, std::size_t bytes)
+{
+    lua_State* state{lua.lua_state()};
+
+    lua_pushinteger(state, static_cast<lua_Integer>(bytes));
+    lua_rawsetp(state, LUA_REGISTRYINDEX, &ScriptBudget::memoryLimitKey);
+}
+
 MapTemplateSettings readTemplateSettings(const std::filesystem::path& templatePath, sol::state& lua)
 {
-    std::string code{readFile(templatePath)};
+    lua_State* state{lua.lua_state()};
+    ScriptBudget budget{state};
+
+    try {
+        loadTemplate(templatePath, state);
+    } catch (const TemplateException&) {
+        budget.check();
+        throw;
+    }
+
+    sol::protected_function chunk(state, -1);
+    lua_pop(state, 1);
 
     // Execute script
-    auto result = lua.safe_script(code, [](lua_State*, sol::protected_function_result pfr) {
-        return pfr;
-    });
+    auto result = chunk();
 
     if (!result.valid()) {
-        const sol::error err = result;
+        budget.check();
 
+        const sol::error err = result;
         throw TemplateException(err.what());
     }
 
@@ -1119,13 +1373,28 @@ void readTemplateContents(MapTemplate& mapTemplate, sol::state& lua)
 
     auto getContents = object.value().as<sol::protected_function>();
 
+    ScriptBudget budget{lua.lua_state()};
+
     auto result = getContents(mapTemplate.settings.races, mapTemplate.settings.size,
                               mapTemplate.settings.parametersValues);
 
     if (result.valid()) {
-        sol::table contents = result;
-        readContents(mapTemplate, contents);
+        lua_State* state{lua.lua_state()};
+
+        if (lua_type(state, result.stack_index()) != LUA_TTABLE) {
+            throw TemplateException("'getContents' must return a table");
+        }
+
+        try {
+            readContents(mapTemplate, state, result.stack_index());
+        } catch (const TemplateException&) {
+            // Metamethods called during conversion are limited too
+            budget.check();
+            throw;
+        }
     } else {
+        budget.check();
+
         sol::error err = result;
         throw TemplateException(std::string("Could not get template contents: ") + err.what());
     }
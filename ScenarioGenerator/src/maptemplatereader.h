@@ -31,6 +31,20 @@ namespace rsg {
 // Binds lua api that is specific for scenario generator
 void bindLuaApi(sol::state& lua);
 
+// Sets folder where compiled templates are cached, empty path disables caching.
+// Folder is created if needed and must be owned by current user, others lose access to it.
+// Compiled templates are signed with a key kept in the folder, files with wrong signatures
+// are compiled again. Compiled template is used while template code and Lua version stay the same.
+// Must be called before templates are read.
+// Returns false and disables caching if folder can not be used
+bool setTemplateCacheFolder(const std::filesystem::path& folder);
+
+// Limits memory template code can allocate in specified state during each
+// readTemplateSettings() or readTemplateContents() call, 0 means no limit.
+// Generator settings limit applies too, the smaller one is used.
+// TemplateLimitException is thrown when template exceeds the limit
+void setTemplateMemoryLimit(sol::state& lua, std::size_t bytes);
+
 // Reads scenario template (.lua) file from specified path.
 // Returns MapTemplateSettings with default template settings.
 // Throws exception in case of errors.
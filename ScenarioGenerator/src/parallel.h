@@ -0,0 +1,59 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace rsg {
+
+// Calls 'worker' from specified number of threads, current thread is one of them.
+// Returns when all calls return. Workers usually share an atomic index of the next task.
+// If a thread could not be started, threads started before are joined and exception is rethrown
+template <typename Worker>
+void runInThreads(std::size_t threadsTotal, const Worker& worker)
+{
+    // Joins started threads when leaving scope, including exception from starting a thread
+    struct JoinGuard
+    {
+        std::vector<std::thread> threads;
+
+        ~JoinGuard()
+        {
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+    };
+
+    JoinGuard guard;
+    if (threadsTotal > 1) {
+        guard.threads.reserve(threadsTotal - 1);
+    }
+
+    for (std::size_t i = 1; i < threadsTotal; ++i) {
+        guard.threads.emplace_back(worker);
+    }
+
+    worker();
+}
+
+} // namespace rsg
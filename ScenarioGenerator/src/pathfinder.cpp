@@ -0,0 +1,97 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pathfinder.h"
+#include <algorithm>
+
+namespace rsg {
+
+void PathFinder::resize(int mapSize)
+{
+    const auto total{static_cast<std::size_t>(mapSize * mapSize)};
+
+    size = mapSize;
+    generation = 0;
+
+    openedStamps.assign(total, 0u);
+    closedStamps.assign(total, 0u);
+    distances.assign(total, 0);
+    cameFrom.assign(total, -1);
+
+    visited.clear();
+    visited.reserve(total);
+}
+
+void PathFinder::beginSearch(int maxStepCost)
+{
+    assert(size > 0);
+
+    if (++generation == 0) {
+        // Stamps wrapped around, old marks could be mistaken for current ones
+        std::fill(openedStamps.begin(), openedStamps.end(), 0u);
+        std::fill(closedStamps.begin(), closedStamps.end(), 0u);
+        generation = 1;
+    }
+
+    const auto bucketsTotal{static_cast<std::size_t>(maxStepCost + 1)};
+    if (buckets.size() < bucketsTotal) {
+        buckets.resize(bucketsTotal);
+    }
+
+    for (auto& bucket : buckets) {
+        bucket.clear();
+    }
+
+    bucketHead = 0;
+    openCount = 0;
+    currentDistance = 0;
+    visited.clear();
+}
+
+void PathFinder::open(int index, int parent, int distance)
+{
+    openedStamps[index] = generation;
+    distances[index] = distance;
+    cameFrom[index] = parent;
+
+    buckets[distance % buckets.size()].push_back(index);
+    ++openCount;
+}
+
+bool PathFinder::pop(int& index)
+{
+    while (openCount) {
+        auto& bucket{buckets[currentDistance % buckets.size()]};
+
+        if (bucketHead < bucket.size()) {
+            index = bucket[bucketHead++];
+            --openCount;
+            return true;
+        }
+
+        // Current bucket is drained, move to the next distance
+        bucket.clear();
+        bucketHead = 0;
+        ++currentDistance;
+    }
+
+    return false;
+}
+
+} // namespace rsg
@@ -0,0 +1,240 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "position.h"
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace rsg {
+
+// Shortest path search over map tiles with small positive integer step costs.
+// Open tiles are kept in a bucket queue (Dial's algorithm) instead of a binary heap.
+// Per-tile search state is stored in flat arrays indexed the same way as
+// MapGenerator::posToIndex() does. Each search bumps generation counter and tiles
+// stamped with older generations are treated as unvisited, so nothing is cleared between searches.
+class PathFinder
+{
+public:
+    enum class Neighbors
+    {
+        Direct,             // 4 direct neighbors only
+        All,                // All 8 neighbors
+        DirectThenDiagonal, // Diagonal neighbors are checked only if no direct neighbor was opened
+    };
+
+    // Step cost of tiles that can not be entered
+    static constexpr int impassable{-1};
+
+    // Prepares search state for square map of specified size
+    void resize(int mapSize);
+
+    // Searches for the closest tile that satisfies 'isGoal(position)' starting from 'source'.
+    // 'stepCost(from, to)' returns cost of moving between neighbor tiles
+    // in range [1 : maxStepCost] or impassable.
+    // Returns true if goal was reached, its position is returned by getGoal().
+    template <typename StepCost, typename Goal>
+    bool search(const Position& source,
+                Neighbors neighbors,
+                int maxStepCost,
+                StepCost&& stepCost,
+                Goal&& isGoal);
+
+    const Position& getGoal() const
+    {
+        return goal;
+    }
+
+    // Calls 'f(position, distance)' for each tile of the path found by last successful search,
+    // starting from goal. Source tile is not visited.
+    template <typename F>
+    void foreachPathTile(F&& f) const;
+
+    // Calls 'f(position)' for each tile that was evaluated during last search
+    template <typename F>
+    void foreachVisited(F&& f) const;
+
+private:
+    void beginSearch(int maxStepCost);
+    void open(int index, int parent, int distance);
+    bool pop(int& index);
+
+    bool isInside(const Position& position) const
+    {
+        return position.x >= 0 && position.x < size && position.y >= 0 && position.y < size;
+    }
+
+    int toIndex(const Position& position) const
+    {
+        return position.x + size * position.y;
+    }
+
+    Position toPosition(int index) const
+    {
+        return Position{index % size, index / size};
+    }
+
+    std::vector<std::uint32_t> openedStamps; // Generation in which tile was opened
+    std::vector<std::uint32_t> closedStamps; // Generation in which tile was evaluated
+    std::vector<int> distances;
+    std::vector<int> cameFrom; // Index of previous tile on a path, -1 for source tile
+    std::vector<int> visited;  // Tiles evaluated during last search
+
+    // Bucket queue. Since step costs never exceed maxStepCost,
+    // maxStepCost + 1 buckets are enough to hold all open tiles
+    std::vector<std::vector<int>> buckets;
+    std::size_t bucketHead{}; // Next element to pop from current bucket
+    std::size_t openCount{};
+    int currentDistance{};
+
+    Position goal{-1, -1};
+    int goalIndex{-1};
+    int size{};
+    std::uint32_t generation{};
+};
+
+template <typename StepCost, typename Goal>
+bool PathFinder::search(const Position& source,
+                        Neighbors neighbors,
+                        int maxStepCost,
+                        StepCost&& stepCost,
+                        Goal&& isGoal)
+{
+    // Directions are set clockwise, starting from north, the same way
+    // MapGenerator::foreachDirectNeighbor() and foreachDiagonalNeighbor() do
+    // clang-format off
+    static const std::array<Position, 4> directDirections{{
+        Position{ 0, -1},
+        Position{ 1,  0},
+        Position{ 0,  1},
+        Position{-1,  0}
+    }};
+
+    static const std::array<Position, 4> diagonalDirections{{
+        Position{-1, -1},
+        Position{ 1, -1},
+        Position{-1,  1},
+        Position{ 1,  1}
+    }};
+    // clang-format on
+
+    assert(isInside(source));
+    beginSearch(maxStepCost);
+    open(toIndex(source), -1, 0);
+
+    int index{};
+    while (pop(index)) {
+        if (closedStamps[index] == generation) {
+            // Tile was reached with a shorter distance before
+            continue;
+        }
+
+        closedStamps[index] = generation;
+        visited.push_back(index);
+
+        const Position current{toPosition(index)};
+        if (isGoal(current)) {
+            goal = current;
+            goalIndex = index;
+            return true;
+        }
+
+        const int distance{distances[index]};
+
+        auto relax = [&](const Position& direction) {
+            const Position next{current + direction};
+            if (!isInside(next)) {
+                return false;
+            }
+
+            const int nextIndex{toIndex(next)};
+            if (closedStamps[nextIndex] == generation) {
+                return false;
+            }
+
+            const int cost{stepCost(current, next)};
+            if (cost == impassable) {
+                return false;
+            }
+
+            assert(cost > 0 && cost <= maxStepCost);
+            const int nextDistance{distance + cost};
+
+            if (openedStamps[nextIndex] == generation && distances[nextIndex] <= nextDistance) {
+                return false;
+            }
+
+            open(nextIndex, index, nextDistance);
+            return true;
+        };
+
+        switch (neighbors) {
+        case Neighbors::Direct:
+            for (const auto& direction : directDirections) {
+                relax(direction);
+            }
+            break;
+
+        case Neighbors::All:
+            for (const auto& direction : Position::getDirections()) {
+                relax(direction);
+            }
+            break;
+
+        case Neighbors::DirectThenDiagonal: {
+            bool directOpened{};
+            for (const auto& direction : directDirections) {
+                directOpened |= relax(direction);
+            }
+
+            if (!directOpened) {
+                for (const auto& direction : diagonalDirections) {
+                    relax(direction);
+                }
+            }
+            break;
+        }
+        }
+    }
+
+    goal = Position{-1, -1};
+    goalIndex = -1;
+    return false;
+}
+
+template <typename F>
+void PathFinder::foreachPathTile(F&& f) const
+{
+    for (int index = goalIndex; index != -1 && cameFrom[index] != -1; index = cameFrom[index]) {
+        f(toPosition(index), distances[index]);
+    }
+}
+
+template <typename F>
+void PathFinder::foreachVisited(F&& f) const
+{
+    for (const auto index : visited) {
+        f(toPosition(index));
+    }
+}
+
+} // namespace rsg
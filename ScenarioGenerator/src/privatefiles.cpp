@@ -0,0 +1,109 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "privatefiles.h"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace rsg {
+
+static long long getProcessId()
+{
+#ifdef _WIN32
+    return ::_getpid();
+#else
+    return ::getpid();
+#endif
+}
+
+bool createPrivateFolder(const std::filesystem::path& folder)
+{
+    std::error_code error;
+    std::filesystem::create_directories(folder, error);
+    if (error) {
+        return false;
+    }
+
+#ifdef _WIN32
+    // Folders inside user profile inherit access rights of the user, nothing to check
+    return std::filesystem::is_directory(folder, error);
+#else
+    struct stat status{};
+    if (::lstat(folder.c_str(), &status) == -1 || !S_ISDIR(status.st_mode)
+        || status.st_uid != ::geteuid()) {
+        return false;
+    }
+
+    if ((status.st_mode & (S_IRWXG | S_IRWXO)) && ::chmod(folder.c_str(), S_IRWXU) == -1) {
+        return false;
+    }
+
+    return true;
+#endif
+}
+
+bool replaceFile(const std::filesystem::path& filePath, std::string_view data)
+{
+    std::random_device randomDevice;
+    const std::uint64_t random{(std::uint64_t{randomDevice()} << 32) | randomDevice()};
+
+    char suffix[64]{};
+    std::snprintf(suffix, sizeof(suffix), ".%lld-%016llx.tmp",
+                  getProcessId(), static_cast<unsigned long long>(random));
+
+    auto temporaryPath{filePath};
+    temporaryPath += suffix;
+
+    std::error_code error;
+
+    {
+        std::ofstream stream(temporaryPath, std::ios::binary);
+        std::filesystem::permissions(temporaryPath,
+                                     std::filesystem::perms::owner_read
+                                         | std::filesystem::perms::owner_write,
+                                     error);
+
+        stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!stream || error) {
+            stream.close();
+            std::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporaryPath, filePath, error);
+    if (error) {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace rsg
@@ -0,0 +1,37 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+namespace rsg {
+
+// Creates folder if needed and makes sure only current user can change its contents.
+// Returns false if folder can not be created or is owned by someone else
+bool createPrivateFolder(const std::filesystem::path& folder);
+
+// Writes data to a file unique for this process and thread first, then replaces file at once.
+// Other threads or processes could write the same file at the same time.
+// File is readable by current user only. Returns false in case of errors
+bool replaceFile(const std::filesystem::path& filePath, std::string_view data);
+
+} // namespace rsg
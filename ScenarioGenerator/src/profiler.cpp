@@ -0,0 +1,197 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "profiler.h"
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace rsg {
+
+std::atomic<bool> Profiler::enabled{false};
+
+struct StageEvent
+{
+    const char* name;
+    Profiler::Clock::time_point start;
+    Profiler::Clock::duration duration;
+    int zoneId;
+};
+
+struct ThreadEvents
+{
+    std::vector<StageEvent> events;
+    std::uint32_t threadId{};
+};
+
+// Buffers of all threads that recorded something.
+// Buffers are shared so events are kept after their threads finish
+static std::mutex buffersMutex;
+static std::vector<std::shared_ptr<ThreadEvents>> buffers;
+
+static ThreadEvents& getThreadEvents()
+{
+    thread_local std::shared_ptr<ThreadEvents> threadEvents;
+
+    if (!threadEvents) {
+        threadEvents = std::make_shared<ThreadEvents>();
+        threadEvents->events.reserve(1024);
+
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        threadEvents->threadId = static_cast<std::uint32_t>(buffers.size() + 1);
+        buffers.push_back(threadEvents);
+    }
+
+    return *threadEvents;
+}
+
+// Chrome trace stores time in microseconds
+static double toMicroseconds(Profiler::Clock::duration duration)
+{
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+static double toMilliseconds(Profiler::Clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void Profiler::record(const char* name, int zoneId, Clock::time_point start, Clock::time_point end)
+{
+    getThreadEvents().events.push_back(StageEvent{name, start, end - start, zoneId});
+}
+
+void Profiler::clear()
+{
+    std::lock_guard<std::mutex> lock(buffersMutex);
+
+    for (auto& buffer : buffers) {
+        buffer->events.clear();
+    }
+}
+
+void Profiler::writeChromeTrace(std::ostream& stream)
+{
+    std::lock_guard<std::mutex> lock(buffersMutex);
+
+    // Earliest recorded stage is the beginning of a trace
+    auto origin{Clock::time_point::max()};
+    for (const auto& buffer : buffers) {
+        for (const auto& event : buffer->events) {
+            origin = std::min(origin, event.start);
+        }
+    }
+
+    // Do not leave formatting changes on the stream
+    const auto flags{stream.flags()};
+    const auto precision{stream.precision()};
+
+    stream << "{\"traceEvents\":[";
+    stream << std::fixed << std::setprecision(3);
+
+    bool first{true};
+    for (const auto& buffer : buffers) {
+        for (const auto& event : buffer->events) {
+            if (!first) {
+                stream << ',';
+            }
+
+            first = false;
+            // Stage names are identifiers, no escaping needed
+            stream << "\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                   << buffer->threadId << ",\"ts\":" << toMicroseconds(event.start - origin)
+                   << ",\"dur\":" << toMicroseconds(event.duration);
+
+            if (event.zoneId != -1) {
+                stream << ",\"args\":{\"zone\":" << event.zoneId << '}';
+            }
+
+            stream << '}';
+        }
+    }
+
+    stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    stream.flags(flags);
+    stream.precision(precision);
+}
+
+void Profiler::writeSummary(std::ostream& stream)
+{
+    struct StageSummary
+    {
+        std::size_t calls{};
+        Clock::duration total{};
+        Clock::duration max{};
+    };
+
+    std::map<std::string, StageSummary> stages;
+
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+
+        for (const auto& buffer : buffers) {
+            for (const auto& event : buffer->events) {
+                auto& summary{stages[event.name]};
+
+                ++summary.calls;
+                summary.total += event.duration;
+                summary.max = std::max(summary.max, event.duration);
+            }
+        }
+    }
+
+    std::vector<std::pair<std::string, StageSummary>> sorted(stages.begin(), stages.end());
+    // Most expensive stages first
+    std::sort(sorted.begin(), sorted.end(),
+              [](const auto& a, const auto& b) { return a.second.total > b.second.total; });
+
+    std::size_t nameWidth{5};
+    for (const auto& [name, summary] : sorted) {
+        nameWidth = std::max(nameWidth, name.size());
+    }
+
+    // Do not leave formatting changes on the stream
+    const auto flags{stream.flags()};
+    const auto precision{stream.precision()};
+
+    stream << std::left << std::setw(nameWidth) << "Stage" << std::right << std::setw(8)
+           << "Calls" << std::setw(14) << "Total, ms" << std::setw(14) << "Average, ms"
+           << std::setw(14) << "Max, ms" << '\n';
+
+    stream << std::fixed << std::setprecision(3);
+    for (const auto& [name, summary] : sorted) {
+        const auto average{summary.total / static_cast<Clock::rep>(summary.calls)};
+
+        stream << std::left << std::setw(nameWidth) << name << std::right << std::setw(8)
+               << summary.calls << std::setw(14) << toMilliseconds(summary.total)
+               << std::setw(14) << toMilliseconds(average) << std::setw(14)
+               << toMilliseconds(summary.max) << '\n';
+    }
+
+    stream.flags(flags);
+    stream.precision(precision);
+}
+
+} // namespace rsg
@@ -0,0 +1,104 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+
+namespace rsg {
+
+// Stage profiler of scenario generation.
+// Each thread records finished stages into its own buffer, buffers are merged only on output.
+// When profiler is disabled, stage timer costs a single atomic load.
+class Profiler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static void setEnabled(bool value)
+    {
+        enabled.store(value, std::memory_order_relaxed);
+    }
+
+    static bool isEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    // Stage name must be a string literal or outlive the profiler data
+    static void record(const char* name, int zoneId, Clock::time_point start, Clock::time_point end);
+
+    // Functions below must not be called while stages are being recorded.
+    // Removes all recorded stages
+    static void clear();
+    // Writes recorded stages in Chrome trace event format (chrome://tracing, Perfetto)
+    static void writeChromeTrace(std::ostream& stream);
+    // Writes table with number of calls, total, average and maximum time of each stage
+    static void writeSummary(std::ostream& stream);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+// Measures time of a stage from construction to destruction
+class StageTimer
+{
+public:
+    // Zone id is shown in stage arguments, -1 means stage does not belong to a zone
+    StageTimer(const char* name, int zoneId = -1)
+        : name{Profiler::isEnabled() ? name : nullptr}
+        , zoneId{zoneId}
+    {
+        if (this->name) {
+            start = Profiler::Clock::now();
+        }
+    }
+
+    ~StageTimer()
+    {
+        if (name) {
+            Profiler::record(name, zoneId, start, Profiler::Clock::now());
+        }
+    }
+
+    // Finishes current stage and starts the next one
+    void next(const char* nextName)
+    {
+        if (name) {
+            const auto now{Profiler::Clock::now()};
+
+            Profiler::record(name, zoneId, start, now);
+            name = nextName;
+            start = now;
+        }
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    const char* name;
+    Profiler::Clock::time_point start;
+    int zoneId;
+};
+
+} // namespace rsg
@@ -19,11 +19,12 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 #include <ctime>
 #include <functional>
-#include <numeric>
 #include <random>
 #include <thread>
 #include <type_traits>
@@ -54,65 +55,137 @@ struct RandomValue
     }
 };
 
-class RandomGenerator
+// Engines random generator can use.
+// Same seed and engine produce the same values with any compiler and standard library
+enum class RandomEngine
+{
+    MersenneTwister, // std::mt19937, used by default
+    Xoshiro,         // xoshiro256**, faster and has smaller state
+};
+
+// Returns engine name used in command line options and scenario descriptions
+inline const char* getRandomEngineName(RandomEngine engine)
+{
+    return engine == RandomEngine::Xoshiro ? "xoshiro" : "mt19937";
+}
+
+// Finds engine by its name, returns false if name is unknown
+inline bool findRandomEngine(const char* name, RandomEngine& engine)
+{
+    for (auto value : {RandomEngine::MersenneTwister, RandomEngine::Xoshiro}) {
+        if (!std::strcmp(name, getRandomEngineName(value))) {
+            engine = value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// xoshiro256** generator by David Blackman and Sebastiano Vigna.
+// https://prng.di.unimi.it/xoshiro256starstar.c
+class Xoshiro256
 {
 public:
-    using RandI64 = std::function<std::int64_t()>;
-    using Rand = std::function<double()>;
-    using Engine = std::mt19937;
+    using result_type = std::uint64_t;
 
-    RandomGenerator()
+    static constexpr result_type min()
     {
-        resetSeed();
+        return 0;
     }
 
-    // Returns random integer value according to its range
-    template <typename T, std::enable_if_t<std::is_integral<T>::value, bool> = true>
-    T pickValue(const RandomValue<T>& value)
+    static constexpr result_type max()
     {
-        return static_cast<T>(getInt64Range(value.min, value.max)());
+        return ~result_type{0};
     }
 
-    // Returns floating point value according to its range
-    template <typename T, std::enable_if_t<std::is_floating_point<T>::value, bool> = true>
-    T pickValue(const RandomValue<T>& value)
+    // Fills state using SplitMix64 as recommended by authors
+    void seed(std::uint64_t value)
     {
-        return static_cast<T>(getDoubleRange(value.min, value.max)());
+        for (auto& word : state) {
+            value += 0x9e3779b97f4a7c15ull;
+
+            std::uint64_t z{value};
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            word = z ^ (z >> 31);
+        }
     }
 
-    // Returns functor that produces random integer values in [min : max] range
-    RandI64 getInt64Range(std::int64_t min, std::int64_t max)
+    result_type operator()()
     {
-        using Distribution = std::uniform_int_distribution<std::int64_t>;
+        const std::uint64_t result{rotl(state[1] * 5, 7) * 9};
+        const std::uint64_t t{state[1] << 17};
+
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
 
-        return std::bind(Distribution(min, max), std::ref(engine));
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+
+        return result;
+    }
+
+private:
+    static std::uint64_t rotl(std::uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    std::uint64_t state[4]{};
+};
+
+class RandomGenerator
+{
+public:
+    RandomGenerator(RandomEngine engine = RandomEngine::MersenneTwister)
+        : engine{engine}
+    {
+        resetSeed();
     }
 
-    // Returns functor that produces random floating point values in [min : max] range
-    Rand getDoubleRange(double min, double max)
+    // Returns random integer value according to its range
+    template <typename T, std::enable_if_t<std::is_integral<T>::value, bool> = true>
+    T pickValue(const RandomValue<T>& value)
     {
-        using Distribution = std::uniform_real_distribution<double>;
+        return nextInteger(value.min, value.max);
+    }
 
-        return std::bind(Distribution(min, max), std::ref(engine));
+    // Returns floating point value according to its range
+    template <typename T, std::enable_if_t<std::is_floating_point<T>::value, bool> = true>
+    T pickValue(const RandomValue<T>& value)
+    {
+        return static_cast<T>(nextDouble(value.min, value.max));
     }
 
+    // Returns random integer value in [min : max] range
     template <typename T, std::enable_if_t<std::is_integral<T>::value, bool> = true>
     T nextInteger(T min, T max)
     {
-        return static_cast<T>(getInt64Range(min, max)());
+        assert(min <= max);
+
+        const auto first{static_cast<std::int64_t>(min)};
+        const auto range{static_cast<std::uint64_t>(static_cast<std::int64_t>(max))
+                         - static_cast<std::uint64_t>(first)};
+
+        return static_cast<T>(first + static_cast<std::int64_t>(nextBelowOrEqual(range)));
     }
 
-    // Returns random floating point value in [min : max] range
+    // Returns random floating point value in [min : max) range
     double nextDouble(double min, double max)
     {
-        return getDoubleRange(min, max)();
+        // 53 random bits make uniformly distributed double in [0 : 1) range
+        const double unit{static_cast<double>(next64() >> 11) * 0x1.0p-53};
+        return min + (max - min) * unit;
     }
 
     // Returns true with chance specified by percent
     bool chance(int percent)
     {
         percent = std::clamp(percent, 0, 100);
-        return nextDouble(0, 99) < percent;
+        return nextInteger(0, 99) < percent;
     }
 
     void resetSeed()
@@ -123,25 +196,117 @@ public:
         setSeed(threadIdHash * (std::size_t)std::time(nullptr));
     }
 
-    void setSeed(std::size_t seed)
+    void setSeed(std::uint64_t seed)
+    {
+        // Mersenne twister keeps seeding it always had: lower 32 bits of seed
+        mersenneTwister.seed(static_cast<std::uint32_t>(seed));
+        xoshiro.seed(seed);
+    }
+
+    // Engine change takes effect immediately, set seed afterwards to get reproducible values
+    void setEngine(RandomEngine value)
     {
-        engine.seed(seed);
+        engine = value;
     }
 
-    Engine& getEngine()
+    RandomEngine getEngine() const
     {
         return engine;
     }
 
 private:
-    Engine engine;
+    std::uint32_t next32()
+    {
+        if (engine == RandomEngine::Xoshiro) {
+            // Upper bits of xoshiro256** are the best ones
+            return static_cast<std::uint32_t>(xoshiro() >> 32);
+        }
+
+        return static_cast<std::uint32_t>(mersenneTwister());
+    }
+
+    std::uint64_t next64()
+    {
+        if (engine == RandomEngine::Xoshiro) {
+            return xoshiro();
+        }
+
+        const std::uint64_t high{mersenneTwister()};
+        return (high << 32) | mersenneTwister();
+    }
+
+    // Returns uniformly distributed value in [0 : range]
+    std::uint64_t nextBelowOrEqual(std::uint64_t range)
+    {
+        if (range < 0xffffffffull) {
+            // Lemire's nearly divisionless method, https://arxiv.org/abs/1805.10941
+            const auto bound{static_cast<std::uint32_t>(range + 1)};
+
+            std::uint64_t m{std::uint64_t{next32()} * bound};
+            auto low{static_cast<std::uint32_t>(m)};
+
+            if (low < bound) {
+                const std::uint32_t threshold{(0u - bound) % bound};
+
+                while (low < threshold) {
+                    m = std::uint64_t{next32()} * bound;
+                    low = static_cast<std::uint32_t>(m);
+                }
+            }
+
+            return m >> 32;
+        }
+
+        if (range == 0xffffffffull) {
+            return next32();
+        }
+
+        if (range == ~std::uint64_t{0}) {
+            return next64();
+        }
+
+        // Wide ranges are rare, use simple rejection with bit mask
+        std::uint64_t mask{range};
+        mask |= mask >> 1;
+        mask |= mask >> 2;
+        mask |= mask >> 4;
+        mask |= mask >> 8;
+        mask |= mask >> 16;
+        mask |= mask >> 32;
+
+        std::uint64_t value{};
+        do {
+            value = next64() & mask;
+        } while (value > range);
+
+        return value;
+    }
+
+    std::mt19937 mersenneTwister;
+    Xoshiro256 xoshiro;
+    RandomEngine engine;
 };
 
+// Returns seed of an independent random stream derived from base seed and stream index.
+// SplitMix64 finalizer makes streams of neighbor seeds or indices unrelated
+static inline std::uint64_t deriveSeed(std::uint64_t seed, std::uint64_t stream)
+{
+    std::uint64_t z{seed + (stream + 1) * 0x9e3779b97f4a7c15ull};
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+
+    return z ^ (z >> 31);
+}
+
 // Reorders elements in container randomly.
+// Fisher-Yates shuffle, gives the same order with any standard library
 template <typename T>
 static inline void randomShuffle(std::vector<T>& container, RandomGenerator& rand)
 {
-    std::shuffle(container.begin(), container.end(), rand.getEngine());
+    for (std::size_t i = container.size(); i > 1; --i) {
+        const auto j{rand.nextInteger(std::size_t{0}, i - 1)};
+        std::swap(container[i - 1], container[j]);
+    }
 }
 
 // Returns a randomly chosen vector of n positive integers summing exactly to total
@@ -151,25 +316,36 @@ static inline std::vector<std::size_t> constrainedSum(std::size_t n,
                                                       std::size_t total,
                                                       RandomGenerator& rand)
 {
-    std::vector<std::size_t> tmp(total);
-    std::iota(tmp.begin(), tmp.end(), 1);
+    // Dividers are distinct values from [1 : total] range, each subset is equally likely.
+    // Floyd's sampling algorithm needs memory and random draws only for the dividers themselves
+    const std::size_t dividersTotal{std::min(n - 1, total)};
 
     std::vector<std::size_t> dividers;
-    std::sample(tmp.begin(), tmp.end(), std::back_inserter(dividers), n - 1, rand.getEngine());
-
-    std::sort(dividers.begin(), dividers.end());
-
-    std::vector<std::size_t> a = dividers;
-    a.push_back(total);
-
-    std::vector<std::size_t> b = dividers;
-    b.insert(b.begin(), 0);
+    dividers.reserve(dividersTotal + 1);
+
+    for (std::size_t j = total - dividersTotal + 1; j <= total; ++j) {
+        const auto value{rand.nextInteger(std::size_t{1}, j)};
+
+        // Keep dividers sorted, there are only a few of them
+        auto it{std::lower_bound(dividers.begin(), dividers.end(), value)};
+        if (it != dividers.end() && *it == value) {
+            // Value is already picked, take j instead. It is larger than all picked values
+            dividers.push_back(j);
+        } else {
+            dividers.insert(it, value);
+        }
+    }
 
     std::vector<std::size_t> result;
-    for (std::size_t i = 0; i < a.size(); ++i) {
-        result.push_back(a[i] - b[i]);
+    result.reserve(dividers.size() + 1);
+
+    std::size_t previous{};
+    for (const auto divider : dividers) {
+        result.push_back(divider - previous);
+        previous = divider;
     }
 
+    result.push_back(total - previous);
     return result;
 }
 
@@ -173,6 +173,12 @@ public:
 
     void toString(char* idString) const;
 
+    /** Returns raw 32 bit value. */
+    constexpr std::uint32_t getValue() const
+    {
+        return value;
+    }
+
 private:
     friend struct CMidgardIDHash;
 
@@ -18,6 +18,7 @@
  */
 
 #include "map.h"
+#include "bytesink.h"
 #include "diplomacy.h"
 #include "gameinfo.h"
 #include "mapblock.h"
@@ -26,6 +27,7 @@
 #include "mountains.h"
 #include "plan.h"
 #include "player.h"
+#include "profiler.h"
 #include "questlog.h"
 #include "scenarioinfo.h"
 #include "scenariovariables.h"
@@ -86,7 +88,16 @@ Map::Map()
 
 void Map::serialize(const std::filesystem::path& scenarioFilePath)
 {
-    Serializer serializer{scenarioFilePath};
+    FileSink sink{scenarioFilePath};
+    serialize(sink);
+    sink.flush();
+}
+
+void Map::serialize(ByteSink& sink)
+{
+    StageTimer timer{"serialize"};
+
+    Serializer serializer{sink};
 
     std::vector<RaceType> races;
     visit(CMidgardID::Type::Player, [this, &races](const ScenarioObject* object) {
@@ -106,6 +117,10 @@ void Map::serialize(const std::filesystem::path& scenarioFilePath)
     createMapBlocks();
     createNeutralSubraces();
 
+    // Rough estimate: header takes a few kilobytes,
+    // map blocks and other objects take up to several hundreds bytes each
+    sink.reserve(8192 + objects.size() * 256);
+
     // Write header, TODO: use scenario info for this
     serializer.serialize(*this, scenarioId, races);
 
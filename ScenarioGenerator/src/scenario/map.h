@@ -34,6 +34,7 @@
 
 namespace rsg {
 
+class ByteSink;
 class Plan;
 class MapElement;
 class Diplomacy;
@@ -87,7 +88,10 @@ public:
     Map();
     ~Map() = default;
 
+    // Writes scenario to file, file is written at once when scenario is serialized
     void serialize(const std::filesystem::path& scenarioFilePath);
+    // Writes scenario bytes to sink
+    void serialize(ByteSink& sink);
 
     void initTerrain();
     void calculateGuardingCreaturePositions();
@@ -18,22 +18,21 @@
  */
 
 #include "serializer.h"
+#include "bytesink.h"
 #include "currency.h"
 #include "map.h"
 #include "position.h"
 #include "rsgid.h"
 #include <cassert>
-#include <fstream>
-#include <iomanip>
+#include <cstring>
+#include <limits>
 #include <stdexcept>
 
 namespace rsg {
 
-Serializer::Serializer(const std::filesystem::path& scenarioFilePath)
-    : stream{scenarioFilePath, std::ios_base::binary}
-{
-    assert(stream.is_open());
-}
+Serializer::Serializer(ByteSink& sink)
+    : sink{sink}
+{ }
 
 void Serializer::enterRecord()
 {
@@ -56,13 +55,13 @@ void Serializer::leaveRecord()
 void Serializer::beginObject()
 {
     serializeName("BEGOBJECT");
-    stream << std::ends;
+    serializeEnd();
 }
 
 void Serializer::endObject()
 {
     serializeName("ENDOBJECT");
-    stream << std::ends;
+    serializeEnd();
 }
 
 void Serializer::serialize(const MapHeader& header,
@@ -94,7 +93,7 @@ void Serializer::serialize(const MapHeader& header,
         scenarioId.toString(idString);
 
         serializeName(idString.data());
-        stream << std::ends;
+        serializeEnd();
     }
 
     serializeString(header.description.c_str(), 256);
@@ -118,7 +117,7 @@ void Serializer::serialize(const MapHeader& header,
     // Campaign id
     {
         serializeName("C000CC0001");
-        stream << std::ends;
+        serializeEnd();
     }
 
     // suggested level
@@ -190,9 +189,8 @@ void Serializer::serialize(const char* name, const char* value)
     // + 1 for null terminator
     serializeValue(stringLength + 1);
 
-    stream.write(value, stringLength);
-    // Write null terminator
-    stream << std::ends;
+    write(value, stringLength);
+    serializeEnd();
 }
 
 void Serializer::serialize(const char* name, const CMidgardID& id)
@@ -232,13 +230,13 @@ void Serializer::serialize(const char* name, const void* buffer, std::size_t byt
 
     serializeName(name);
     serializeValue(static_cast<std::uint32_t>(byteCount));
-    stream.write(reinterpret_cast<const char*>(buffer), byteCount);
+    write(buffer, byteCount);
 }
 
 void Serializer::serializeName(const char* name)
 {
     // Names are not null terminated
-    stream.write(name, std::strlen(name));
+    write(name, std::strlen(name));
 }
 
 void Serializer::serializeString(const char* value, std::size_t bytesToWrite)
@@ -246,10 +244,18 @@ void Serializer::serializeString(const char* value, std::size_t bytesToWrite)
     const auto stringLength{std::strlen(value)};
     const auto length{std::min(stringLength, bytesToWrite)};
 
-    stream.write(value, length);
+    write(value, length);
+    sink.writeZeros(bytesToWrite - length);
+}
 
-    std::vector<char> padding(bytesToWrite - length, '\0');
-    stream.write(padding.data(), padding.size());
+void Serializer::serializeEnd()
+{
+    sink.writeZeros(1);
+}
+
+void Serializer::write(const void* data, std::size_t byteCount)
+{
+    sink.write(data, byteCount);
 }
 
 } // namespace rsg
@@ -22,12 +22,12 @@
 #include "enums.h"
 #include <cstddef>
 #include <cstdint>
-#include <filesystem>
-#include <fstream>
+#include <type_traits>
 #include <vector>
 
 namespace rsg {
 
+class ByteSink;
 class CMidgardID;
 class Currency;
 struct Position;
@@ -36,7 +36,7 @@ struct MapHeader;
 class Serializer
 {
 public:
-    Serializer(const std::filesystem::path& scenarioFilePath);
+    Serializer(ByteSink& sink);
 
     void enterRecord();
     void leaveRecord();
@@ -62,14 +62,18 @@ public:
 private:
     void serializeName(const char* name);
     void serializeString(const char* value, std::size_t bytesToWrite);
+    // Writes null terminator
+    void serializeEnd();
 
     template <typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
     void serializeValue(const T& value)
     {
-        stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        write(&value, sizeof(value));
     }
 
-    std::ofstream stream;
+    void write(const void* data, std::size_t byteCount);
+
+    ByteSink& sink;
     bool insideRecord{false};
 };
 
@@ -40,7 +40,7 @@ static SpellInfo* pickSpell(const SpellInfoArray& spellsPool,
         return nullptr;
     }
 
-    const auto index{static_cast<std::size_t>(random.getInt64Range(0, pool.size() - 1)())};
+    const std::size_t index{random.nextInteger(std::size_t{0}, pool.size() - 1)};
     return pool[index];
 }
 
@@ -25,7 +25,6 @@
 #include "exceptions.h"
 #include "generatorsettings.h"
 #include "item.h"
-#include "itempicker.h"
 #include "knownspells.h"
 #include "playerbuildings.h"
 #include "landmarkpicker.h"
@@ -34,7 +33,9 @@
 #include "maptemplate.h"
 #include "mercenary.h"
 #include "merchant.h"
+#include "pathfinder.h"
 #include "player.h"
+#include "profiler.h"
 #include "resourcemarket.h"
 #include "spellpicker.h"
 #include "subrace.h"
@@ -46,6 +47,7 @@
 #include <cassert>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <sstream>
 
 
@@ -139,22 +141,19 @@ static void checkObjectsAccess(const MapGenerator& mapGenerator, const Map& map)
     });
 }
 
+TemplateZone::TemplateZone(MapGenerator* mapGenerator)
+    : mapGenerator{mapGenerator}
+    , tileInfo{mapGenerator->mapGenOptions.size}
+    , possibleTiles{mapGenerator->mapGenOptions.size}
+    , freePaths{mapGenerator->mapGenOptions.size}
+    , roadNodes{mapGenerator->mapGenOptions.size}
+    , distanceField{mapGenerator}
+    , availabilityIndex{mapGenerator}
+{ }
+
 void TemplateZone::setCenter(const VPosition& value)
 {
-    // Wrap zone around (0, 1) square.
-    // If it doesn't fit on one side, will come out on the opposite side.
-    center = value;
-
-    center.x = static_cast<float>(std::fmod(center.x, 1));
-    center.y = static_cast<float>(std::fmod(center.y, 1));
-
-    if (center.x < 0.f) {
-        center.x = 1.f - std::abs(center.x);
-    }
-
-    if (center.y < 0.f) {
-        center.y = 1.f - std::abs(center.y);
-    }
+    center = value.wrapped();
 }
 
 void TemplateZone::clearEntrance(const Fortification& fort)
@@ -196,11 +195,11 @@ void TemplateZone::initTowns()
 
 void TemplateZone::initFreeTiles()
 {
-    std::copy_if(tileInfo.begin(), tileInfo.end(),
-                 std::inserter(possibleTiles, possibleTiles.end()),
-                 [this](const Position& position) {
-                     return this->mapGenerator->isPossible(position);
-                 });
+    for (const auto& tile : tileInfo) {
+        if (mapGenerator->isPossible(tile) && possibleTiles.insert(tile)) {
+            distanceField.insert(tile);
+        }
+    }
 
     // Zone must have at least one free tile where other paths go - for instance in the center
     if (freePaths.empty()) {
@@ -245,7 +244,7 @@ void TemplateZone::createBorder()
                     break;
 
                 case ZoneBorderType::SemiOpen: {
-                    const bool gap{mapGenerator->randomGenerator.chance(gapChance)};
+                    const bool gap{randomGenerator.chance(gapChance)};
 
                     mapGenerator->setOccupied(tile, gap ? TileType::Free : TileType::Blocked);
                     if (gap) {
@@ -275,21 +274,35 @@ void TemplateZone::createBorder()
 
 void TemplateZone::fill()
 {
+    StageTimer timer{"fill.initTerrain", id};
     initTerrain();
 
     // Zone center should be always clear to allow other tiles to connect
+    timer.next("fill.initFreeTiles");
     initFreeTiles();
+    timer.next("fill.fractalize");
     fractalize();
+    timer.next("fill.placeCities");
     placeCities();
+    timer.next("fill.placeMerchants");
     placeMerchants();
+    timer.next("fill.placeMages");
     placeMages();
+    timer.next("fill.placeMercenaries");
     placeMercenaries();
+    timer.next("fill.placeTrainers");
     placeTrainers();
+    timer.next("fill.placeMarkets");
     placeMarkets();
+    timer.next("fill.placeRuins");
     placeRuins();
+    timer.next("fill.placeMines");
     placeMines();
+    timer.next("fill.createRequiredObjects");
     createRequiredObjects();
+    timer.next("fill.placeStacks");
     placeStacks();
+    timer.next("fill.placeBags");
     placeBags();
 
     if (mapGenerator->isDebugMode()) {
@@ -306,8 +319,7 @@ void TemplateZone::createObstacles()
 
     // Place decorations first
     for (const auto& decoration : decorations) {
-        decoration->decorate(*this, *mapGenerator, *mapGenerator->map,
-                             mapGenerator->randomGenerator);
+        decoration->decorate(*this, *mapGenerator, *mapGenerator->map, randomGenerator);
     }
 
     decorations.clear();
@@ -341,7 +353,7 @@ void TemplateZone::createObstacles()
               });
 
     auto tryPlaceMountainHere = [this, &possibleObstacles](const Position& tile, int index) {
-        auto& rand{mapGenerator->randomGenerator};
+        auto& rand{randomGenerator};
 
         const auto it{getRandomElement(possibleObstacles[index].second, rand)};
 
@@ -421,7 +433,7 @@ void TemplateZone::createObstacles()
         return;
     }
 
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
 
     for (auto& tile : tileInfo) {
         if (mapGenerator->isPossible(tile)) {
@@ -453,8 +465,8 @@ void TemplateZone::connectRoads()
         std::cout << "Started building roads\n";
     }
 
-    std::set<Position> roadNodesCopy{roadNodes};
-    std::set<Position> processed;
+    TileSet roadNodesCopy{roadNodes};
+    TileSet processed{mapGenerator->mapGenOptions.size};
 
     while (!roadNodesCopy.empty()) {
         auto node{*roadNodesCopy.begin()};
@@ -485,7 +497,7 @@ void TemplateZone::connectRoads()
             // Don't draw road starting at end point which is already connected
             processed.insert(cross);
 
-            eraseIfPresent(roadNodesCopy, cross);
+            roadNodesCopy.erase(cross);
         }
 
         processed.insert(node);
@@ -1015,12 +1027,7 @@ bool TemplateZone::guardObject(const MapElement& mapElement, const GroupInfo& gu
 
 void TemplateZone::updateDistances(const Position& position)
 {
-    for (auto& tile : possibleTiles) {
-        const auto distance{static_cast<float>(position.distanceSquared(tile))};
-        const auto currentDistance{mapGenerator->getNearestObjectDistance(tile)};
-
-        mapGenerator->setNearestObjectDistance(tile, std::min(distance, currentDistance));
-    }
+    distanceField.addObject(position, possibleTiles);
 }
 
 void TemplateZone::addRoadNode(const Position& position)
@@ -1038,93 +1045,49 @@ bool TemplateZone::connectWithCenter(const Position& position,
                                      bool onlyStraight,
                                      bool passThroughBlocked)
 {
-    // A* algorithm
-
-    // Nodes that are already evaluated
-    std::set<Position> closed;
-    // The set of tentative nodes to be evaluated, initially containing the start node
-    PriorityQueue queue;
-    // Map of navigated nodes
-    std::map<Position, Position> cameFrom;
-    std::map<Position, float> distances;
-
-    // First node points to finish condition.
-    // Invalid position of (-1 -1) used as stop element
-    cameFrom[position] = Position(-1, -1);
-    queue.push(std::make_pair(position, 0.f));
-    distances[position] = 0.f;
-
-    while (!queue.empty()) {
-        auto node = queue.top();
-        // Remove top element
-        queue.pop();
-
-        const auto& currentNode{node.first};
-        closed.insert(currentNode);
-
-        // Reached center of the zone, stop
-        if (currentNode == pos) {
-            // Trace the path using the saved parent information and return path
-            Position backTracking{currentNode};
-            while (cameFrom[backTracking].isValid()) {
-                mapGenerator->setOccupied(backTracking, TileType::Free);
-                backTracking = cameFrom[backTracking];
-            }
+    // We prefer to use already free paths
+    auto stepCost = [this, passThroughBlocked](const Position&, const Position& p) {
+        if (mapGenerator->getZoneId(p) != id) {
+            return PathFinder::impassable;
+        }
 
-            return true;
-        } else {
-            auto functor = [this, &queue, &closed, &cameFrom, &currentNode, &distances,
-                            passThroughBlocked](Position& p) {
-                if (contains(closed, p)) {
-                    return;
-                }
+        if (mapGenerator->isFree(p)) {
+            return 1;
+        }
 
-                if (mapGenerator->getZoneId(p) != id) {
-                    return;
-                }
+        if (mapGenerator->isPossible(p)) {
+            return 2;
+        }
 
-                float movementCost{};
-                if (mapGenerator->isFree(p)) {
-                    movementCost = 1.f;
-                } else if (mapGenerator->isPossible(p)) {
-                    movementCost = 2.f;
-                } else if (passThroughBlocked && mapGenerator->shouldBeBlocked(p)) {
-                    movementCost = 3.f;
-                } else {
-                    return;
-                }
+        if (passThroughBlocked && mapGenerator->shouldBeBlocked(p)) {
+            return 3;
+        }
 
-                // We prefer to use already free paths
-                const float distance{distances[currentNode] + movementCost};
-                auto bestDistanceSoFar{std::numeric_limits<int>::max()};
+        return PathFinder::impassable;
+    };
 
-                auto it{distances.find(p)};
-                if (it != distances.end()) {
-                    bestDistanceSoFar = static_cast<int>(it->second);
-                }
+    // Stop at the center of the zone
+    auto isCenter = [this](const Position& p) { return p == pos; };
 
-                if (distance < bestDistanceSoFar) {
-                    cameFrom[p] = currentNode;
-                    queue.push(std::make_pair(p, distance));
-                    distances[p] = distance;
-                }
-            };
+    auto& pathFinder{mapGenerator->pathFinder};
+    const auto neighbors{onlyStraight ? PathFinder::Neighbors::Direct
+                                      : PathFinder::Neighbors::All};
 
-            if (onlyStraight) {
-                mapGenerator->foreachDirectNeighbor(currentNode, functor);
-            } else {
-                mapGenerator->foreachNeighbor(currentNode, functor);
-            }
-        }
+    if (!pathFinder.search(position, neighbors, 3, stepCost, isCenter)) {
+        return false;
     }
 
-    return false;
+    pathFinder.foreachPathTile([this](const Position& tile, int) {
+        mapGenerator->setOccupied(tile, TileType::Free);
+    });
+
+    return true;
 }
 
 bool TemplateZone::crunchPath(const Position& source,
                               const Position& destination,
                               bool onlyStraight,
-                              std::set<Position>* clearedTiles)
+                              TileSet* clearedTiles)
 {
     bool result{};
     bool end{};
@@ -1245,84 +1208,45 @@ bool TemplateZone::crunchPath(const Position& source,
 
 bool TemplateZone::connectPath(const Position& source, bool onlyStraight)
 {
-    // A* algorithm
-
-    // The set of nodes already evaluated
-    std::set<Position> closed;
-    // The set of tentative nodes to be evaluated, initially containing the start node
-    PriorityQueue open;
-    // The map of navigated nodes
-    std::map<Position, Position> cameFrom;
-    std::map<Position, float> distances;
-
-    // First node points to finish condition
-    cameFrom[source] = Position{-1, -1};
-    distances[source] = 0.f;
-    open.push({source, 0.f});
-
-    // Cost from start along best known path.
-    // Estimated total cost from start to goal through y.
-
-    while (!open.empty()) {
-        auto node{open.top()};
-        open.pop();
-        const auto currentNode{node.first};
-
-        closed.insert(currentNode);
-
-        // We reached free paths, stop
-        if (mapGenerator->isFree(currentNode)) {
-            // Trace the path using the saved parent information and return path
-            auto backTracking{currentNode};
-            while (cameFrom[backTracking].isValid()) {
-                mapGenerator->setOccupied(backTracking, TileType::Free);
-                backTracking = cameFrom[backTracking];
-            }
-
-            mapGenerator->setOccupied(backTracking, TileType::Free);
-            return true;
+    // No paths through blocked or occupied tiles, stay within zone
+    auto stepCost = [this](const Position&, const Position& p) {
+        if (mapGenerator->isBlocked(p) || mapGenerator->getZoneId(p) != id) {
+            return PathFinder::impassable;
         }
 
-        auto functor = [this, &open, &closed, &cameFrom, &currentNode, &distances](Position& pos) {
-            if (contains(closed, pos)) {
-                return;
-            }
-
-            // No paths through blocked or occupied tiles, stay within zone
-            if (mapGenerator->isBlocked(pos) || mapGenerator->getZoneId(pos) != id) {
-                return;
-            }
+        return 1;
+    };
 
-            const auto distance{static_cast<int>(distances[currentNode]) + 1};
-            int bestDistanceSoFar{std::numeric_limits<int>::max()};
+    // We reached free paths, stop
+    auto isFree = [this](const Position& p) { return mapGenerator->isFree(p); };
 
-            auto it{distances.find(pos)};
-            if (it != distances.end()) {
-                bestDistanceSoFar = static_cast<int>(it->second);
-            }
+    auto& pathFinder{mapGenerator->pathFinder};
+    const auto neighbors{onlyStraight ? PathFinder::Neighbors::Direct
+                                      : PathFinder::Neighbors::All};
 
-            if (distance < bestDistanceSoFar) {
-                cameFrom[pos] = currentNode;
-                open.push({pos, static_cast<float>(distance)});
-                distances[pos] = static_cast<float>(distance);
-            }
-        };
+    if (pathFinder.search(source, neighbors, 1, stepCost, isFree)) {
+        pathFinder.foreachPathTile([this](const Position& tile, int) {
+            mapGenerator->setOccupied(tile, TileType::Free);
+        });
 
-        if (onlyStraight) {
-            mapGenerator->foreachDirectNeighbor(currentNode, functor);
-        } else {
-            mapGenerator->foreachNeighbor(currentNode, functor);
-        }
+        mapGenerator->setOccupied(source, TileType::Free);
+        return true;
     }
 
     // These tiles are sealed off and can't be connected anymore
-    for (const auto& tile : closed) {
+    pathFinder.foreachVisited([this](const Position& tile) {
         if (mapGenerator->isPossible(tile)) {
             mapGenerator->setOccupied(tile, TileType::Blocked);
         }
 
-        eraseIfPresent(possibleTiles, tile);
-    }
+        possibleTiles.erase(tile);
+
+        // Tiles under blueprint become possible again when it is removed,
+        // keep them as candidates for object placement
+        if (!mapGenerator->isUsed(tile)) {
+            distanceField.erase(tile);
+        }
+    });
 
     return false;
 }
@@ -1334,7 +1258,7 @@ std::unique_ptr<Stack> TemplateZone::createStack(const GroupInfo& stackInfo, boo
         return nullptr;
     }
 
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
 
     int strength = static_cast<int>(rand.pickValue(stackValue));
 
@@ -1494,7 +1418,7 @@ std::unique_ptr<Stack> TemplateZone::createStack(const UnitInfo& leaderInfo,
                                                  const GroupUnits& groupUnits,
                                                  bool neutralOwner)
 {
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
 
     // Create stack
     auto stackId{mapGenerator->createId(CMidgardID::Type::Stack)};
@@ -1526,7 +1450,7 @@ const UnitInfo* TemplateZone::pickStackLeader(std::size_t& unusedValue,
                                               const std::vector<std::size_t>& unitValues,
                                               std::set<CMidgardID> leaderIds)
 {
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
 
     auto leadersRequired = [leaderIds](const UnitInfo* info) {
         return !contains(leaderIds, info->getUnitId());
@@ -1562,7 +1486,7 @@ const UnitInfo* TemplateZone::createStackLeader(std::size_t& unusedValue,
                                                 const std::vector<std::size_t>& unitValues,
                                                 const std::set<SubRaceType>& allowedSubraces)
 {
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
 
     // How many failed attempts considered as a stop condition
     constexpr std::size_t totalFails{5};
@@ -1647,7 +1571,7 @@ void TemplateZone::createGroup(std::size_t& unusedValue,
                                const std::vector<std::size_t>& unitValues,
                                const std::set<SubRaceType>& allowedSubraces)
 {
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
 
     // Pick soldier units 1 by 1, starting from value that was not used for leader
     for (std::size_t i = 0; i < unitValues.size() && !positions.empty(); ++i) {
@@ -1745,7 +1669,7 @@ void TemplateZone::tightenGroup(std::size_t& unusedValue,
                                 GroupUnits& groupUnits,
                                 const std::set<SubRaceType>& allowedSubraces)
 {
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
 
     // Start with somewhat relaxed minimum value.
     // Gradually decrease min value expectation as we struggle to pick units
@@ -1880,7 +1804,7 @@ void TemplateZone::createGroupUnits(Group& group, const GroupUnits& groupUnits)
 
 Village* TemplateZone::placeCity(const Position& position, const CityInfo& cityInfo)
 {
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
 
     // Create city of specified tier, assign position, owner, subrace
     auto villageId{mapGenerator->createId(CMidgardID::Type::Fortification)};
@@ -2019,7 +1943,7 @@ Village* TemplateZone::placeCity(const Position& position, const CityInfo& cityI
 
 Site* TemplateZone::placeMerchant(const Position& position, const MerchantInfo& merchantInfo)
 {
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
 
     auto merchantId{mapGenerator->createId(CMidgardID::Type::Site)};
     auto merchant{std::make_unique<Merchant>(merchantId)};
@@ -2055,7 +1979,7 @@ Site* TemplateZone::placeMerchant(const Position& position, const MerchantInfo&
 
 Site* TemplateZone::placeMage(const Position& position, const MageInfo& mageInfo)
 {
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
 
     auto mageId{mapGenerator->createId(CMidgardID::Type::Site)};
     auto mage{std::make_unique<Mage>(mageId)};
@@ -2147,7 +2071,7 @@ Site* TemplateZone::placeMage(const Position& position, const MageInfo& mageInfo
 
 Site* TemplateZone::placeMercenary(const Position& position, const MercenaryInfo& mercInfo)
 {
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
 
     auto mercenaryId{mapGenerator->createId(CMidgardID::Type::Site)};
     auto mercenary{std::make_unique<Mercenary>(mercenaryId)};
@@ -2232,7 +2156,7 @@ Site* TemplateZone::placeMercenary(const Position& position, const MercenaryInfo
 
 Site* TemplateZone::placeTrainer(const Position& position, const TrainerInfo& trainerInfo)
 {
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
 
     auto trainerId{mapGenerator->createId(CMidgardID::Type::Site)};
     auto trainer{std::make_unique<Trainer>(trainerId)};
@@ -2263,7 +2187,7 @@ Site* TemplateZone::placeTrainer(const Position& position, const TrainerInfo& tr
 
 Site* TemplateZone::placeMarket(const Position& position, const ResourceMarketInfo& marketInfo)
 {
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
 
     auto marketId{mapGenerator->createId(CMidgardID::Type::Site)};
     auto market{std::make_unique<ResourceMarket>(marketId)};
@@ -2307,7 +2231,7 @@ Site* TemplateZone::placeMarket(const Position& position, const ResourceMarketIn
 
 Ruin* TemplateZone::placeRuin(const Position& position, const RuinInfo& ruinInfo)
 {
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
 
     auto ruinId{mapGenerator->createId(CMidgardID::Type::Ruin)};
     auto ruin{std::make_unique<Ruin>(ruinId)};
@@ -2414,7 +2338,7 @@ Bag* TemplateZone::placeBag(const Position& position)
     const auto& bagImages = mapGenerator->map->getTile(position).isWater() ? bags.waterImages
                                                                            : bags.images;
 
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
     // Pick random bag image with respect to ground type
     bag->setImage(*getRandomElement(bagImages, rand));
 
@@ -2427,7 +2351,7 @@ Bag* TemplateZone::placeBag(const Position& position)
 std::vector<std::pair<CMidgardID, int>> TemplateZone::createLoot(const LootInfo& loot,
                                                                  bool forMerchant)
 {
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
 
     std::vector<std::pair<CMidgardID, int>> items;
 
@@ -2451,44 +2375,21 @@ std::vector<std::pair<CMidgardID, int>> TemplateZone::createLoot(const LootInfo&
         const int desiredValue{static_cast<int>(rand.pickValue(value))};
         int currentValue{};
 
-        auto noWrongType = [types = &loot.itemTypes, forMerchant](const ItemInfo* info) {
-            if (forMerchant && info->getItemType() == ItemType::Valuable) {
-                // Do not generate valuables as merchant goods
-                return true;
-            }
-
-            if (types->empty()) {
-                return false;
-            }
-
-            // Remove items of types that is not allowed
-            return types->find(info->getItemType()) == types->end();
-        };
-
-        auto noForbiddenOnTemplate = [this](const ItemInfo* info) {
-            return contains(mapGenerator->mapGenOptions.mapTemplate->settings.forbiddenItems,
-                            info->getItemId());
-        };
-
         const auto& itemValue{loot.itemValue};
 
         int picked{};
         while (currentValue <= desiredValue) {
             const int remainingValue = desiredValue - currentValue;
 
-            auto noWrongValue = [remainingValue, &itemValue](const ItemInfo* info) {
-                if (itemValue
-                    && (info->getValue() < itemValue.min || info->getValue() > itemValue.max)) {
-                    // If user specified single item value range,
-                    // filter items that are outside of it
-                    return true;
-                }
+            // If user specified single item value range, pick items only from it
+            const int minValue{itemValue ? static_cast<int>(itemValue.min)
+                                         : std::numeric_limits<int>::min()};
+            const int maxValue{itemValue ? std::min(static_cast<int>(itemValue.max), remainingValue)
+                                         : remainingValue};
 
-                return info->getValue() > static_cast<int>(remainingValue);
-            };
-
-            auto item{pickItem(rand, {noWrongType, noWrongValue, noSpecialItem,
-                                      noForbiddenOnTemplate, noForbiddenItem})};
+            // Do not generate valuables as merchant goods
+            auto item{mapGenerator->itemCatalog.pick(rand, loot.itemTypes, forMerchant, minValue,
+                                                     maxValue)};
             if (!item) {
                 // Could not pick anything, stop
                 break;
@@ -2539,8 +2440,8 @@ void TemplateZone::fractalize()
     }
 
     std::vector<Position> clearedTiles(freePaths.begin(), freePaths.end());
-    std::set<Position> possibleTiles;
-    std::set<Position> tilesToIgnore;
+    TileSet possibleTiles{mapGenerator->mapGenOptions.size};
+    TileSet tilesToIgnore{mapGenerator->mapGenOptions.size};
 
     // TODO: move this setting into template for better zone free space control
     // TODO: adjust this setting based on template value
@@ -2564,7 +2465,7 @@ void TemplateZone::fractalize()
         while (!possibleTiles.empty()) {
             // Link tiles in random order
             std::vector<Position> tilesToMakePath(possibleTiles.begin(), possibleTiles.end());
-            randomShuffle(tilesToMakePath, mapGenerator->randomGenerator);
+            randomShuffle(tilesToMakePath, randomGenerator);
 
             Position nodeFound{-1, -1};
 
@@ -2600,7 +2501,7 @@ void TemplateZone::fractalize()
 
             // These tiles are already connected, ignore them
             for (const auto& tileToClear : tilesToIgnore) {
-                eraseIfPresent(possibleTiles, tileToClear);
+                possibleTiles.erase(tileToClear);
             }
 
             // Nothing else can be done (?)
@@ -2652,7 +2553,7 @@ void TemplateZone::fractalize()
             continue;
         }
 
-        if (freePaths.count(tile)) {
+        if (freePaths.contains(tile)) {
             continue;
         }
 
@@ -2684,7 +2585,7 @@ void TemplateZone::fractalize()
 
 void TemplateZone::placeCapital()
 {
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
 
     // Create capital id
     auto capitalId{mapGenerator->createId(CMidgardID::Type::Fortification)};
@@ -3110,7 +3011,7 @@ void TemplateZone::placeStacks()
         }
     }
 
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
 
     // Make sure stacks from different groups are mixed on the map
     randomShuffle(positions, rand);
@@ -3259,7 +3160,7 @@ void TemplateZone::placeBags()
         requiredItems.insert(requiredItems.end(), amount, id);
     }
 
-    auto& rand{mapGenerator->randomGenerator};
+    auto& rand{randomGenerator};
 
     // Place required items in the bags randomly
     for (const auto& id : requiredItems) {
@@ -3433,7 +3334,7 @@ bool TemplateZone::createRequiredObjects()
 
             for (const auto& tile : tiles) {
                 // Code partially adapted from findPlaceForObject()
-                if (!areAllTilesAvailable(requiredMapElement, tile, tilesBlockedByObject)) {
+                if (!areAllTilesAvailable(requiredMapElement, tile)) {
                     continue;
                 }
 
@@ -3489,7 +3390,17 @@ bool TemplateZone::findPlaceForObject(const MapElement& mapElement,
                                       int minDistance,
                                       Position& position)
 {
-    return findPlaceForObject(tileInfo, mapElement, minDistance, position);
+    // Same as searching whole zone area, but farthest tiles are checked first
+    // and search stops at the first suitable one
+    return distanceField.findFarthest(
+        static_cast<float>(minDistance),
+        [this, &mapElement](const Position& tile) {
+            return !mapGenerator->map->isAtTheBorder(mapElement, tile)
+                   && isAccessibleFromSomewhere(mapElement, tile)
+                   && isEntranceAccessible(mapElement, tile) && mapGenerator->isPossible(tile)
+                   && areAllTilesAvailable(mapElement, tile);
+        },
+        position);
 }
 
 bool TemplateZone::findPlaceForObject(const std::set<Position>& area,
@@ -3497,12 +3408,29 @@ bool TemplateZone::findPlaceForObject(const std::set<Position>& area,
                                       int minDistance,
                                       Position& position,
                                       bool findAccessible)
+{
+    return findPlaceInArea(area, mapElement, minDistance, position, findAccessible);
+}
+
+bool TemplateZone::findPlaceForObject(const TileSet& area,
+                                      const MapElement& mapElement,
+                                      int minDistance,
+                                      Position& position,
+                                      bool findAccessible)
+{
+    return findPlaceInArea(area, mapElement, minDistance, position, findAccessible);
+}
+
+template <typename Area>
+bool TemplateZone::findPlaceInArea(const Area& area,
+                                   const MapElement& mapElement,
+                                   int minDistance,
+                                   Position& position,
+                                   bool findAccessible)
 {
     float bestDistance{0.f};
     bool result{};
 
-    auto blockedOffsets{mapElement.getBlockedOffsets()};
-
     for (const auto& tile : area) {
         // Avoid borders
         if (mapGenerator->map->isAtTheBorder(mapElement, tile)) {
@@ -3531,7 +3459,7 @@ bool TemplateZone::findPlaceForObject(const std::set<Position>& area,
         const bool distanceMoreThanBest{distance > bestDistance};
 
         if (distanceMoreThanMin && distanceMoreThanBest) {
-            if (areAllTilesAvailable(mapElement, tile, blockedOffsets)) {
+            if (areAllTilesAvailable(mapElement, tile)) {
                 bestDistance = distance;
                 position = tile;
                 result = true;
@@ -3630,21 +3558,9 @@ std::vector<Position> TemplateZone::getAccessibleTiles(const MapElement& mapElem
     return tiles;
 }
 
-bool TemplateZone::areAllTilesAvailable(const MapElement& mapElement,
-                                        const Position& position,
-                                        const std::set<Position>& blockedOffsets) const
+bool TemplateZone::areAllTilesAvailable(const MapElement& mapElement, const Position& position)
 {
-    for (const auto& offset : blockedOffsets) {
-        const auto t{position + offset};
-
-        if (!mapGenerator->map->isInTheMap(t) || !mapGenerator->isPossible(t)
-            || mapGenerator->getZoneId(t) != id) {
-            // If at least one tile is not possible, object can't be placed here
-            return false;
-        }
-    }
-
-    return true;
+    return availabilityIndex.isAreaAvailable(id, tileInfo, position, mapElement.getSize());
 }
 
 bool TemplateZone::canObstacleBePlacedHere(const MapElement& mapElement,
@@ -3697,113 +3613,72 @@ bool TemplateZone::isInTheZone(const Position& position) const
 
 bool TemplateZone::createRoad(const Position& source, const Position& destination)
 {
-    // A* algorithm
-
-    // The set of nodes already evaluated
-    std::set<Position> closed;
-    // The set of tentative nodes to be evaluated, initially containing the start node
-    PriorityQueue queue;
-    // The map of navigated nodes
-    std::map<Position, Position> cameFrom;
-    std::map<Position, float> distances;
+    // Path finder works with integer costs, road distances are scaled by this value
+    constexpr int costScale{10};
+    constexpr int straightCost{costScale};
+    // Moving diagonally is penalized over moving two tiles straight
+    constexpr int diagonalCost{21};
 
     // Just in case zone guard already has road under it
     // Road under nodes will be added at very end
     mapGenerator->setRoad(source, false);
 
-    // First node points to finish condition
-    cameFrom[source] = Position{-1, -1};
-    queue.push({source, 0.f});
-    distances[source] = 0.f;
-    // Cost from start along best known path
-
-    RoadInfo road;
-    road.source = source;
-    road.destination = destination;
-
-    while (!queue.empty()) {
-        auto node{queue.top()};
-        queue.pop();
-
-        auto& currentNode{node.first};
-        closed.insert(currentNode);
-
-        if (currentNode == destination || mapGenerator->isRoad(currentNode)) {
-            // The goal node was reached.
-            // Trace the path using the saved parent information and return path
-            Position backtracking{currentNode};
-            while (cameFrom[backtracking].isValid()) {
-                // Add node to path
-                road.path.push({backtracking, distances[backtracking]});
-                mapGenerator->setRoad(backtracking, true);
-                backtracking = cameFrom[backtracking];
-            }
-
-            roads.push_back(road);
-            return true;
+    auto stepCost = [this, &destination](const Position& from, const Position& to) {
+        const auto& tile{mapGenerator->map->getTile(to)};
+        if (tile.isWater()) {
+            return PathFinder::impassable;
         }
 
-        const auto& currentTile{mapGenerator->map->getTile(currentNode)};
-        bool directNeighbourFound{false};
-        float movementCost{1.f};
-
-        auto functor = [this, &queue, &distances, &closed, &cameFrom, &currentNode, &currentTile,
-                        &node, &destination, &directNeighbourFound, &movementCost](Position& p) {
-            if (contains(closed, p)) {
-                // We already visited that node
-                return;
-            }
+        const auto& currentTile{mapGenerator->map->getTile(from)};
 
-            float distance{node.second + movementCost};
-            float bestDistanceSoFar{std::numeric_limits<float>::max()};
+        const auto emptyPath{mapGenerator->isFree(to) && mapGenerator->isFree(from)};
+        // Moving from or to visitable object
+        const auto visitable{(tile.visitable || currentTile.visitable)
+                             && mapGenerator->map->canMoveBetween(from, to)};
+        // Already completed the path
+        const auto completed{to == destination};
 
-            auto it{distances.find(p)};
-            if (it != distances.end()) {
-                bestDistanceSoFar = it->second;
-            }
-
-            if (distance >= bestDistanceSoFar) {
-                return;
-            }
+        if (!(emptyPath || visitable || completed)) {
+            return PathFinder::impassable;
+        }
 
-            auto& tile{mapGenerator->map->getTile(p)};
-            if (tile.isWater()) {
-                return;
-            }
+        // Otherwise guard position may appear already connected to other zone.
+        if (mapGenerator->getZoneId(to) != id && !completed) {
+            return PathFinder::impassable;
+        }
 
-            const auto canMoveBetween{mapGenerator->map->canMoveBetween(currentNode, p)};
+        const bool straight{from.x == to.x || from.y == to.y};
+        return straight ? straightCost : diagonalCost;
+    };
 
-            const auto emptyPath{mapGenerator->isFree(p) && mapGenerator->isFree(currentNode)};
-            // Moving from or to visitable object
-            const auto visitable{(tile.visitable || currentTile.visitable) && canMoveBetween};
-            // Already completed the path
-            const auto completed{p == destination};
+    auto isRoadEnd = [this, &destination](const Position& p) {
+        return p == destination || mapGenerator->isRoad(p);
+    };
 
-            if (emptyPath || visitable || completed) {
-                // Otherwise guard position may appear already connected to other zone.
-                if (mapGenerator->getZoneId(p) == id || completed) {
-                    cameFrom[p] = currentNode;
-                    distances[p] = distance;
-                    queue.push({p, distance});
-                    directNeighbourFound = true;
-                }
-            }
-        };
+    auto& pathFinder{mapGenerator->pathFinder};
 
-        // Roads cannot be placed diagonally
-        mapGenerator->foreachDirectNeighbor(currentNode, functor);
-        if (!directNeighbourFound) {
-            // Moving diagonally is penalized over moving two tiles straight
-            movementCost = 2.1f;
-            mapGenerator->foreachDiagonalNeighbor(currentNode, functor);
+    // Roads cannot be placed diagonally
+    if (!pathFinder.search(source, PathFinder::Neighbors::DirectThenDiagonal, diagonalCost,
+                           stepCost, isRoadEnd)) {
+        if (mapGenerator->isDebugMode()) {
+            std::cout << "Failed create road from " << source << " to " << destination << '\n';
         }
-    }
 
-    if (mapGenerator->isDebugMode()) {
-        std::cout << "Failed create road from " << source << " to " << destination << '\n';
+        return false;
     }
 
-    return false;
+    RoadInfo road;
+    road.source = source;
+    road.destination = destination;
+
+    pathFinder.foreachPathTile([this, &road](const Position& tile, int distance) {
+        // Add node to path
+        road.path.push({tile, static_cast<float>(distance) / costScale});
+        mapGenerator->setRoad(tile, true);
+    });
+
+    roads.push_back(road);
+    return true;
 }
 
 } // namespace rsg
@@ -19,9 +19,12 @@
 
 #pragma once
 
+#include "availabilityindex.h"
 #include "decoration.h"
+#include "distancefield.h"
 #include "gameinfo.h"
 #include "position.h"
+#include "randomgenerator.h"
 #include "scenario/bag.h"
 #include "scenario/crystal.h"
 #include "scenario/fortification.h"
@@ -29,6 +32,7 @@
 #include "scenario/ruin.h"
 #include "scenario/site.h"
 #include "scenario/stack.h"
+#include "tileset.h"
 #include "vposition.h"
 #include "zoneoptions.h"
 #include <memory>
@@ -68,9 +72,7 @@ struct RoadInfo
 // Describes zone in a template
 struct TemplateZone : public ZoneOptions
 {
-    TemplateZone(MapGenerator* mapGenerator)
-        : mapGenerator{mapGenerator}
-    { }
+    TemplateZone(MapGenerator* mapGenerator);
 
     const VPosition& getCenter() const
     {
@@ -94,6 +96,17 @@ struct TemplateZone : public ZoneOptions
         ZoneOptions::operator=(options);
     }
 
+    // Sets up zone random stream using map seed and zone id.
+    // Zone contents do not depend on other zones or the order zones are filled in
+    void setRandomSeed(std::time_t mapSeed, RandomEngine engine)
+    {
+        const auto seed{deriveSeed(static_cast<std::uint64_t>(mapSeed),
+                                   static_cast<std::uint64_t>(id))};
+
+        randomGenerator.setEngine(engine);
+        randomGenerator.setSeed(seed);
+    }
+
     void addTile(const Position& position)
     {
         tileInfo.insert(position);
@@ -103,6 +116,7 @@ struct TemplateZone : public ZoneOptions
     {
         tileInfo.erase(position);
         possibleTiles.erase(position);
+        distanceField.erase(position);
     }
 
     void clearTiles()
@@ -110,7 +124,7 @@ struct TemplateZone : public ZoneOptions
         tileInfo.clear();
     }
 
-    const std::set<Position>& getTileInfo() const
+    const TileSet& getTileInfo() const
     {
         return tileInfo;
     }
@@ -191,7 +205,7 @@ struct TemplateZone : public ZoneOptions
     bool crunchPath(const Position& source,
                     const Position& destination,
                     bool onlyStraight,
-                    std::set<Position>* clearedTiles = nullptr);
+                    TileSet* clearedTiles = nullptr);
 
     // Connect specified 'source' tile to nearest free tile with zone
     bool connectPath(const Position& source, bool onlyStraight);
@@ -268,14 +282,19 @@ struct TemplateZone : public ZoneOptions
                             int minDistance,
                             Position& position,
                             bool findAccessible = true);
+    bool findPlaceForObject(const TileSet& area,
+                            const MapElement& mapElement,
+                            int minDistance,
+                            Position& position,
+                            bool findAccessible = true);
     bool isAccessibleFromSomewhere(const MapElement& mapElement, const Position& position) const;
     bool isEntranceAccessible(const MapElement& mapElement, const Position& position) const;
     Position getAccessibleOffset(const MapElement& mapElement, const Position& position) const;
     // Returns all tiles from which specified map element can be accessed
     std::vector<Position> getAccessibleTiles(const MapElement& mapElement) const;
-    bool areAllTilesAvailable(const MapElement& mapElement,
-                              const Position& position,
-                              const std::set<Position>& blockedOffsets) const;
+    // Returns true if all tiles covered by map element placed at position are possible
+    // and belong to the zone
+    bool areAllTilesAvailable(const MapElement& mapElement, const Position& position);
     bool canObstacleBePlacedHere(const MapElement& mapElement, const Position& position) const;
 
     void paintZoneTerrain(TerrainType terrain, GroundType ground);
@@ -288,7 +307,15 @@ struct TemplateZone : public ZoneOptions
 private:
     bool createRoad(const Position& source, const Position& destination);
 
+    template <typename Area>
+    bool findPlaceInArea(const Area& area,
+                         const MapElement& mapElement,
+                         int minDistance,
+                         Position& position,
+                         bool findAccessible);
+
     MapGenerator* mapGenerator{};
+    RandomGenerator randomGenerator;
 
     // Template info
     TerrainType terrainType{TerrainType::Neutral};
@@ -311,10 +338,13 @@ private:
     // Placement info
     Position pos;
     VPosition center;
-    std::set<Position> tileInfo;      // Area assigned to zone
-    std::set<Position> possibleTiles; // For treasure generation
-    std::set<Position> freePaths;     // Paths of free tiles that all objects will be linked to
-    std::set<Position> roadNodes;     // Tiles to be connected with roads
+    TileSet tileInfo;      // Area assigned to zone
+    TileSet possibleTiles; // For treasure generation
+    TileSet freePaths;     // Paths of free tiles that all objects will be linked to
+    TileSet roadNodes;     // Tiles to be connected with roads
+    // Distances from possible tiles to placed objects, used to spread objects across the zone
+    DistanceField distanceField;
+    AvailabilityIndex availabilityIndex;
 
     std::vector<RoadInfo> roads; // All tiles with roads
     CMidgardID ownerId{emptyId}; // Player assigned to zone
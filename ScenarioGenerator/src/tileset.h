@@ -0,0 +1,256 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "position.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace rsg {
+
+// Set of map tiles backed by a map-sized bitmap.
+// Membership checks and size are O(1), iteration goes in row order:
+// the same order std::set<Position> uses, so tiles are visited the same way.
+class TileSet
+{
+public:
+    using value_type = Position;
+
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Position;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Position*;
+        using reference = const Position&;
+
+        Iterator() = default;
+
+        reference operator*() const
+        {
+            return position;
+        }
+
+        pointer operator->() const
+        {
+            return &position;
+        }
+
+        Iterator& operator++()
+        {
+            index = tiles->findNext(index + 1);
+            position = tiles->toPosition(index);
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator tmp{*this};
+            ++(*this);
+            return tmp;
+        }
+
+        bool operator==(const Iterator& other) const
+        {
+            return index == other.index;
+        }
+
+        bool operator!=(const Iterator& other) const
+        {
+            return index != other.index;
+        }
+
+    private:
+        friend class TileSet;
+
+        Iterator(const TileSet* tiles, std::size_t index)
+            : tiles{tiles}
+            , index{index}
+            , position{tiles->toPosition(index)}
+        { }
+
+        const TileSet* tiles{};
+        std::size_t index{};
+        Position position; // Cached position of current tile
+    };
+
+    using iterator = Iterator;
+    using const_iterator = Iterator;
+
+    TileSet() = default;
+
+    // Creates empty set for square map of specified size
+    explicit TileSet(int mapSize)
+        : words((static_cast<std::size_t>(mapSize * mapSize) + wordBits - 1) / wordBits)
+        , mapSize{mapSize}
+    { }
+
+    // Returns true if tile was not in the set
+    bool insert(const Position& position)
+    {
+        const auto index{toIndex(position)};
+        auto& word{words[index / wordBits]};
+        const Word mask{Word{1} << (index % wordBits)};
+
+        if (word & mask) {
+            return false;
+        }
+
+        word |= mask;
+        ++count;
+        return true;
+    }
+
+    // Returns true if tile was in the set
+    bool erase(const Position& position)
+    {
+        if (!isInside(position)) {
+            return false;
+        }
+
+        const auto index{toIndex(position)};
+        auto& word{words[index / wordBits]};
+        const Word mask{Word{1} << (index % wordBits)};
+
+        if (!(word & mask)) {
+            return false;
+        }
+
+        word &= ~mask;
+        --count;
+        return true;
+    }
+
+    bool contains(const Position& position) const
+    {
+        if (!isInside(position)) {
+            return false;
+        }
+
+        const auto index{toIndex(position)};
+        return (words[index / wordBits] >> (index % wordBits)) & Word{1};
+    }
+
+    void clear()
+    {
+        std::fill(words.begin(), words.end(), Word{0});
+        count = 0;
+    }
+
+    std::size_t size() const
+    {
+        return count;
+    }
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    Iterator begin() const
+    {
+        return Iterator{this, findNext(0)};
+    }
+
+    Iterator end() const
+    {
+        return Iterator{this, endIndex()};
+    }
+
+private:
+    using Word = std::uint32_t;
+    static constexpr std::size_t wordBits{32};
+
+    static int countTrailingZeros(Word value)
+    {
+        assert(value != 0);
+#ifdef _MSC_VER
+        unsigned long index{};
+        _BitScanForward(&index, value);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctz(value);
+#endif
+    }
+
+    bool isInside(const Position& position) const
+    {
+        return position.x >= 0 && position.x < mapSize && position.y >= 0 && position.y < mapSize;
+    }
+
+    std::size_t toIndex(const Position& position) const
+    {
+        assert(isInside(position));
+        return static_cast<std::size_t>(position.x + mapSize * position.y);
+    }
+
+    Position toPosition(std::size_t index) const
+    {
+        if (!mapSize) {
+            return Position{};
+        }
+
+        const int i{static_cast<int>(index)};
+        return Position{i % mapSize, i / mapSize};
+    }
+
+    std::size_t endIndex() const
+    {
+        return static_cast<std::size_t>(mapSize * mapSize);
+    }
+
+    // Returns index of first tile in the set starting from specified one, or endIndex()
+    std::size_t findNext(std::size_t index) const
+    {
+        const auto last{endIndex()};
+        if (index >= last) {
+            return last;
+        }
+
+        std::size_t wordIndex{index / wordBits};
+        // Skip tiles before specified one in the first word
+        Word word{words[wordIndex] & (~Word{0} << (index % wordBits))};
+
+        while (!word) {
+            if (++wordIndex == words.size()) {
+                return last;
+            }
+
+            word = words[wordIndex];
+        }
+
+        return wordIndex * wordBits + countTrailingZeros(word);
+    }
+
+    std::vector<Word> words;
+    std::size_t count{};
+    int mapSize{};
+};
+
+} // namespace rsg
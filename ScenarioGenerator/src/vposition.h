@@ -105,6 +105,23 @@ struct VPosition
         return VPosition{x, y} / static_cast<float>(mag());
     }
 
+    // Wraps position around (0, 1) square.
+    // If it doesn't fit on one side, will come out on the opposite side
+    VPosition wrapped() const
+    {
+        VPosition result{static_cast<float>(std::fmod(x, 1)), static_cast<float>(std::fmod(y, 1))};
+
+        if (result.x < 0.f) {
+            result.x = 1.f - std::abs(result.x);
+        }
+
+        if (result.y < 0.f) {
+            result.y = 1.f - std::abs(result.y);
+        }
+
+        return result;
+    }
+
     friend std::ostream& operator<<(std::ostream& os, const VPosition& p)
     {
         return os << '(' << p.x << ", " << p.y << ')';
@@ -21,11 +21,15 @@
 #include "generatorsettings.h"
 #include "mapgenerator.h"
 #include "maptemplate.h"
+#include "parallel.h"
 #include "randomgenerator.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <iostream>
+#include <limits>
+#include <thread>
 
 namespace rsg {
 
@@ -44,108 +48,187 @@ void ZonePlacer::placeZones(RandomGenerator* random)
     gravityConstant = 4e-3f;
     stiffnessConstant = 4e-3f;
 
-    // Yes, copy them
-    auto zones{mapGenerator->zones};
+    const auto& zones{mapGenerator->zones};
+    assert(!zones.empty());
 
-    ZoneVector zonesVector(zones.begin(), zones.end());
-    assert(!zonesVector.empty());
+    placedZones.clear();
+    zoneConnections.clear();
 
-    randomShuffle(zonesVector, *random);
+    std::map<TemplateZoneId, std::size_t> zoneIndices;
+    for (const auto& [id, zone] : zones) {
+        zoneIndices[id] = placedZones.size();
+        placedZones.push_back(zone);
+    }
 
-    // Set zone sizes and surface
-    prepareZones(zones, zonesVector, random);
+    for (const auto& zone : placedZones) {
+        std::vector<std::size_t> connections;
+        for (const auto& connection : zone->connections) {
+            connections.push_back(zoneIndices.at(connection));
+        }
 
-    // Gravity-based algorithm:
-    // connected zones attract, intersecting zones and map boundaries push back
+        zoneConnections.push_back(std::move(connections));
+    }
 
-    // Remember best solution
-    float bestTotalDistance = 1e10;
-    float bestTotalOverlap = 1e10;
-    ForceVector bestSolution;
+    ZoneVector zonesVector(zones.begin(), zones.end());
+    randomShuffle(zonesVector, *random);
 
-    ForceVector forces;
-    ForceVector totalForces;
+    // Set zone sizes and surface
+    Centers startCenters(placedZones.size());
+    prepareZones(zonesVector, startCenters, random);
 
-    DistanceVector distances;
-    DistanceVector overlaps;
+    const auto& templateSettings{mapGenerator->mapGenOptions.mapTemplate->settings};
 
-    const int template_iterations = mapGenerator->mapGenOptions.mapTemplate->settings.iterations;
+    const int template_iterations = templateSettings.iterations;
     int iterations{};
     if (template_iterations) {
         iterations = template_iterations;
     } else {
         iterations = getGeneratorSettings().iterations;
     }
+
+    convergenceWindow = static_cast<int>(templateSettings.convergenceWindow);
+    convergenceThreshold = templateSettings.convergenceThreshold;
+
+    const std::size_t runsTotal{std::max(1u, templateSettings.placementRuns)};
+
+    // First run starts from layout created above, others get their own random streams
+    std::vector<Centers> starts{std::move(startCenters)};
+    if (runsTotal > 1) {
+        const auto baseSeed{random->nextInteger(0u, 0xffffffffu)};
+
+        for (std::size_t run = 1; run < runsTotal; ++run) {
+            RandomGenerator runRandom{random->getEngine()};
+            runRandom.setSeed(deriveSeed(baseSeed, run));
+
+            Centers centers(placedZones.size());
+            createStartingLayout(centers, runRandom);
+            starts.push_back(std::move(centers));
+        }
+    }
+
+    std::vector<Layout> layouts(runsTotal);
+    std::atomic<std::size_t> nextRun{0};
+
+    auto worker = [this, &starts, &layouts, &nextRun, runsTotal, iterations]() {
+        for (auto run = nextRun++; run < runsTotal; run = nextRun++) {
+            layouts[run] = runPlacement(std::move(starts[run]), iterations);
+        }
+    };
+
+    // Current thread runs placement too
+    runInThreads(getThreadsTotal(runsTotal), worker);
+
+    // Runs are compared in order so the same run wins regardless of threads timing
+    std::size_t bestRun{};
+    for (std::size_t run = 1; run < runsTotal; ++run) {
+        const auto& layout{layouts[run]};
+
+        if (layouts[bestRun].isImprovedBy(layout.totalDistance, layout.totalOverlap)) {
+            bestRun = run;
+        }
+    }
+
+    const auto& best{layouts[bestRun]};
+    iterationsMade = best.iterations;
+
+    if (mapGenerator->isDebugMode()) {
+        std::cout << "Best placement run " << bestRun << " of " << runsTotal << ", distance "
+                  << best.totalDistance << ", overlap " << best.totalOverlap << ", iterations "
+                  << best.iterations << " of " << iterations << '\n';
+    }
+
+    // Finalize zone positions
+    for (std::size_t i = 0; i < placedZones.size(); ++i) {
+        auto& zone{placedZones[i]};
+
+        zone->setCenter(best.centers[i]);
+        zone->setPosition(coords(best.centers[i]));
+
+        if (mapGenerator->isDebugMode()) {
+            std::cout << "Place zone " << zone->id << " at " << zone->getCenter()
+                      << " and coordinates " << zone->getPosition() << '\n';
+        }
+    }
+}
+
+ZonePlacer::Layout ZonePlacer::runPlacement(Centers centers, int iterations) const
+{
+    // Gravity-based algorithm:
+    // connected zones attract, intersecting zones and map boundaries push back
+
+    const std::size_t zonesTotal{centers.size()};
+
+    // Remember best solution
+    Layout best;
+    best.centers = centers;
+
+    Forces forces(zonesTotal);
+    Forces totalForces(zonesTotal);
+
+    Distances distances(zonesTotal);
+    Distances overlaps(zonesTotal);
+
+    // Best fitness at the start of current convergence window
+    float windowFitness{best.getFitness()};
+
     // Iterate until zones reach their desired size and fill map completely
     for (int i = 0; i < iterations; ++i) {
+        best.iterations = i + 1;
+
         // Attract connected zones
-        attractConnectedZones(zones, forces, distances);
+        attractConnectedZones(centers, forces, distances);
 
-        for (auto& zone : forces) {
-            zone.first->setCenter(zone.first->getCenter() + zone.second);
+        for (std::size_t j = 0; j < zonesTotal; ++j) {
+            centers[j] = (centers[j] + forces[j]).wrapped();
             // Override
-            totalForces[zone.first] = zone.second;
+            totalForces[j] = forces[j];
         }
 
         // Separate overlapping zones
-        separateOverlappingZones(zones, forces, overlaps);
+        separateOverlappingZones(centers, forces, overlaps);
 
-        for (auto& zone : forces) {
-            zone.first->setCenter(zone.first->getCenter() + zone.second);
+        for (std::size_t j = 0; j < zonesTotal; ++j) {
+            centers[j] = (centers[j] + forces[j]).wrapped();
             // Accumulate
-            totalForces[zone.first] += zone.second;
+            totalForces[j] += forces[j];
         }
 
         // Drastically move zones that is completely not linked
-        moveOneZone(zones, totalForces, distances, overlaps);
+        moveOneZone(centers, totalForces, distances, overlaps);
 
         // Re-evaluate zone positions
-        attractConnectedZones(zones, forces, distances);
-        separateOverlappingZones(zones, forces, overlaps);
+        attractConnectedZones(centers, forces, distances);
+        separateOverlappingZones(centers, forces, overlaps);
 
         // Find most misplaced zone
         float totalDistance{0.f};
         float totalOverlap{0.f};
 
-        for (auto& zone : distances) {
-            totalDistance += zone.second;
-
-            float overlap = overlaps[zone.first];
-            totalOverlap += overlap;
+        for (std::size_t j = 0; j < zonesTotal; ++j) {
+            totalDistance += distances[j];
+            totalOverlap += overlaps[j];
         }
 
-        // Check fitness function
-        bool improvement{};
-        if (bestTotalDistance > 0.0f && bestTotalOverlap > 0.0f) {
-            if (totalDistance * totalOverlap < bestTotalDistance * bestTotalOverlap) {
-                improvement = true;
-            }
-        } else {
-            if (totalDistance + totalOverlap < bestTotalDistance + bestTotalOverlap) {
-                improvement = true;
-            }
+        // Check fitness function and save best solution
+        if (best.isImprovedBy(totalDistance, totalOverlap)) {
+            best.totalDistance = totalDistance;
+            best.totalOverlap = totalOverlap;
+            best.centers = centers;
         }
 
-        // Save best solution
-        if (improvement) {
-            bestTotalDistance = totalDistance;
-            bestTotalOverlap = totalOverlap;
-
-            for (auto& zone : zones) {
-                bestSolution[zone.second] = zone.second->getCenter();
+        if (convergenceWindow && best.iterations % convergenceWindow == 0) {
+            // Stop when improvement over the window is too small to be worth more iterations
+            const float fitness{best.getFitness()};
+            if (windowFitness <= 0.0f
+                || (windowFitness - fitness) * 100.0f < windowFitness * convergenceThreshold) {
+                break;
             }
-        }
-    }
 
-    // Finalize zone positions
-    for (auto& zone : zones) {
-        zone.second->setPosition(coords(bestSolution[zone.second]));
-
-        if (mapGenerator->isDebugMode()) {
-            std::cout << "Place zone " << zone.first << " at " << zone.second->getCenter()
-                      << " and coordinates " << zone.second->getPosition() << '\n';
+            windowFitness = fitness;
         }
     }
+
+    return best;
 }
 
 void ZonePlacer::assignZones()
@@ -154,97 +237,154 @@ void ZonePlacer::assignZones()
         std::cout << "Starting zone coloring\n";
     }
 
-    auto mapWidth{mapGenerator->mapGenOptions.size};
-    auto mapHeight{mapGenerator->mapGenOptions.size};
+    const int size{mapGenerator->mapGenOptions.size};
 
     // Scale to medium map to ensure smooth results
-    scaleX = 96.0f / mapWidth;
-    scaleY = 96.0f / mapHeight;
+    scaleX = 96.0f / size;
+    scaleY = 96.0f / size;
+
+    // Zone positions and sizes are kept in separate arrays
+    // so distances to all zones from a tile are computed in a single vectorizable loop
+    std::vector<std::shared_ptr<TemplateZone>> zones;
+    ZoneArrays arrays;
 
-    // Yes, copy them
-    auto zones = mapGenerator->zones;
+    for (const auto& [id, zone] : mapGenerator->zones) {
+        zones.push_back(zone);
+        arrays.sizes.push_back(static_cast<float>(zone->size));
+    }
 
-    using DistPair = std::pair<std::shared_ptr<TemplateZone>, float>;
-    std::vector<DistPair> distances(zones.size());
+    auto updatePositions = [&zones, &arrays]() {
+        arrays.x.clear();
+        arrays.y.clear();
 
-    auto compareByDistance = [](const DistPair& a, const DistPair& b) -> bool {
-        // Bigger zones have smaller distance
-        return a.second / a.first->size < b.second / b.first->size;
+        for (const auto& zone : zones) {
+            arrays.x.push_back(zone->getPosition().x);
+            arrays.y.push_back(zone->getPosition().y);
+        }
     };
 
-    auto moveToCenterOfMass = [](std::shared_ptr<TemplateZone>& zone) -> void {
-        Position total{};
+    // Moves each zone to center of mass of tiles labeled with its index
+    auto moveToCenterOfMass = [&zones, size](const std::vector<std::uint32_t>& labels) {
+        std::vector<Position> totals(zones.size());
+        std::vector<int> counts(zones.size());
+
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                const auto label{labels[x + size * y]};
 
-        const auto& tiles{zone->getTileInfo()};
-        for (const auto& tile : tiles) {
-            total += tile;
+                totals[label] += Position{x, y};
+                ++counts[label];
+            }
         }
 
-        const auto size{static_cast<int>(tiles.size())};
-        assert(size != 0);
+        for (std::size_t i = 0; i < zones.size(); ++i) {
+            const auto& total{totals[i]};
+            const auto count{counts[i]};
+            assert(count != 0);
 
-        zone->setPosition(Position{total.x / size, total.y / size});
+            zones[i]->setPosition(Position{total.x / count, total.y / count});
+        }
     };
 
+    std::vector<std::uint32_t> labels(static_cast<std::size_t>(size * size));
+
     // Place zones correctly and assign tiles to each zone
 
     // 1. Create Voronoi diagram
     // 2. Find current center of mass for each zone. Move zone to that center to balance zones sizes
-    for (int i = 0; i < mapWidth; ++i) {
-        for (int j = 0; j < mapHeight; ++j) {
-            distances.clear();
-
-            Position pos{i, j};
-            for (auto& zone : zones) {
-                distances.push_back({zone.second, static_cast<float>(pos.distanceSquared(
-                                                      zone.second->getPosition()))});
-            }
+    updatePositions();
+    labelTiles(arrays, labels, [&arrays](int x, int y, std::size_t i) {
+        const auto dx{x - arrays.x[i]};
+        const auto dy{y - arrays.y[i]};
+        const auto distance{static_cast<std::uint32_t>(dx * dx)
+                            + static_cast<std::uint32_t>(dy * dy)};
 
-            auto it{std::min_element(distances.begin(), distances.end(), compareByDistance)};
-            // Closest tile belongs to zone
-            it->first->addTile(pos);
-        }
-    }
+        // Bigger zones have smaller distance
+        return static_cast<float>(distance) / arrays.sizes[i];
+    });
 
-    for (auto& zone : zones) {
-        moveToCenterOfMass(zone.second);
-    }
+    moveToCenterOfMass(labels);
 
     // Assign actual tiles to each zone using nonlinear norm for fine edges
+    updatePositions();
+    labelTiles(arrays, labels, [this, &arrays](int x, int y, std::size_t i) {
+        return metric(Position{x, y}, Position{arrays.x[i], arrays.y[i]}) / arrays.sizes[i];
+    });
 
     // Now populate them again
     for (auto& zone : zones) {
-        zone.second->clearTiles();
+        zone->clearTiles();
     }
 
-    for (int i = 0; i < mapWidth; ++i) {
-        for (int j = 0; j < mapHeight; ++j) {
-            distances.clear();
-
-            Position pos{i, j};
-            for (auto& zone : zones) {
-                distances.push_back({zone.second, metric(pos, zone.second->getPosition())});
-            }
-
-            auto it{std::min_element(distances.begin(), distances.end(), compareByDistance)};
-            auto& zone{it->first};
+    auto& coloring{mapGenerator->zoneColoring};
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            const std::size_t index{static_cast<std::size_t>(x + size * y)};
+            auto& zone{zones[labels[index]]};
 
-            zone->addTile(pos);
-            mapGenerator->setZoneId(pos, zone->id);
+            zone->addTile(Position{x, y});
+            coloring[index] = zone->id;
         }
     }
 
+    mapGenerator->zoneColoringChanged();
+
     // Set position (town position) to center of mass of irregular zone
-    for (auto& zone : zones) {
-        moveToCenterOfMass(zone.second);
-    }
+    moveToCenterOfMass(labels);
 
     if (mapGenerator->isDebugMode()) {
         std::cout << "Finished zone coloring\n";
     }
 }
 
-void ZonePlacer::prepareZones(ZonesMap& zones, ZoneVector& zonesVector, RandomGenerator* random)
+template <typename F>
+void ZonePlacer::labelTiles(const ZoneArrays& arrays,
+                            std::vector<std::uint32_t>& labels,
+                            F&& distance) const
+{
+    const int size{mapGenerator->mapGenOptions.size};
+    const std::size_t zonesTotal{arrays.sizes.size()};
+
+    std::atomic<int> nextRow{0};
+
+    auto worker = [&arrays, &labels, &distance, &nextRow, size, zonesTotal]() {
+        std::vector<float> distances(zonesTotal);
+
+        for (int y = nextRow++; y < size; y = nextRow++) {
+            for (int x = 0; x < size; ++x) {
+                // Independent iterations, compiler vectorizes them
+                for (std::size_t i = 0; i < zonesTotal; ++i) {
+                    distances[i] = distance(x, y, i);
+                }
+
+                // Closest tile belongs to zone, first one wins ties
+                std::uint32_t closest{};
+                for (std::size_t i = 1; i < zonesTotal; ++i) {
+                    if (distances[i] < distances[closest]) {
+                        closest = static_cast<std::uint32_t>(i);
+                    }
+                }
+
+                labels[x + size * y] = closest;
+            }
+        }
+    };
+
+    // Current thread labels tiles too
+    runInThreads(getThreadsTotal(static_cast<std::size_t>(size)), worker);
+}
+
+std::size_t ZonePlacer::getThreadsTotal(std::size_t tasksTotal) const
+{
+    std::size_t threadsTotal{mapGenerator->mapGenOptions.threads};
+    if (!threadsTotal) {
+        threadsTotal = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    return std::max<std::size_t>(1, std::min(threadsTotal, tasksTotal));
+}
+
+void ZonePlacer::prepareZones(ZoneVector& zonesVector, Centers& centers, RandomGenerator* random)
 {
     static constexpr const double pi2{M_PI * 2.0};
     static constexpr const float radius{0.4f};
@@ -257,12 +397,17 @@ void ZonePlacer::prepareZones(ZonesMap& zones, ZoneVector& zonesVector, RandomGe
 
         const float angle{static_cast<float>(random->nextDouble(0, pi2))};
         // Place zones around circle
-        const VPosition center{0.5f + std::sinf(angle) * radius, 0.5f + std::cosf(angle) * radius};
-        zone.second->setCenter(center);
+        const VPosition center{0.5f + std::sin(angle) * radius, 0.5f + std::cos(angle) * radius};
+
+        const auto it{std::find(placedZones.begin(), placedZones.end(), zone.second)};
+        assert(it != placedZones.end());
+
+        auto& zoneCenter{centers[std::distance(placedZones.begin(), it)]};
+        zoneCenter = center.wrapped();
 
         if (mapGenerator->isDebugMode()) {
             std::cout << "Zone " << zone.first << ", vCenter: " << center
-                      << ", center: " << zone.second->getCenter() << '\n';
+                      << ", center: " << zoneCenter << '\n';
         }
     }
 
@@ -279,34 +424,46 @@ void ZonePlacer::prepareZones(ZonesMap& zones, ZoneVector& zonesVector, RandomGe
         std::cout << "Prescaler: " << prescaler << "\nMap size: " << mapSize << '\n';
     }
 
-    for (auto& zone : zones) {
-        const auto size{zone.second->size};
+    for (auto& zone : placedZones) {
+        const auto size{zone->size};
 
-        zone.second->size = static_cast<int>(zone.second->size * prescaler);
+        zone->size = static_cast<int>(zone->size * prescaler);
 
         if (mapGenerator->isDebugMode()) {
-            std::cout << "Zone " << zone.first << ", size: " << size
-                      << ", scaled size: " << zone.second->size << '\n';
+            std::cout << "Zone " << zone->id << ", size: " << size
+                      << ", scaled size: " << zone->size << '\n';
         }
     }
 }
 
-void ZonePlacer::attractConnectedZones(ZonesMap& zones,
-                                       ForceVector& forces,
-                                       DistanceVector& distances)
+void ZonePlacer::createStartingLayout(Centers& centers, RandomGenerator& random) const
 {
-    for (auto& zone : zones) {
-        const auto& pos{zone.second->getCenter()};
+    static constexpr const double pi2{M_PI * 2.0};
+    static constexpr const float radius{0.4f};
+
+    for (auto& center : centers) {
+        const float angle{static_cast<float>(random.nextDouble(0, pi2))};
+        center = VPosition{0.5f + std::sin(angle) * radius, 0.5f + std::cos(angle) * radius}
+                     .wrapped();
+    }
+}
+
+void ZonePlacer::attractConnectedZones(const Centers& centers,
+                                       Forces& forces,
+                                       Distances& distances) const
+{
+    for (std::size_t i = 0; i < centers.size(); ++i) {
+        const auto& pos{centers[i]};
+        const auto zoneSize{placedZones[i]->size};
         VPosition forceVector{};
         float totalDistance{};
 
-        for (auto& connection : zone.second->connections) {
-            auto otherZone{zones[connection]};
-            auto otherZoneCenter{otherZone->getCenter()};
+        for (const auto connection : zoneConnections[i]) {
+            const auto& otherZoneCenter{centers[connection]};
 
             const float distance{static_cast<float>(pos.distance(otherZoneCenter))};
             // Scale down to (0, 1) coordinates
-            const float minDistance{(zone.second->size + otherZone->size) / mapSize};
+            const float minDistance{(zoneSize + placedZones[connection]->size) / mapSize};
 
             if (distance > minDistance) {
                 const float overlapMultiplier{minDistance / distance};
@@ -318,29 +475,30 @@ void ZonePlacer::attractConnectedZones(ZonesMap& zones,
             }
         }
 
-        distances[zone.second] = totalDistance;
-        forces[zone.second] = forceVector;
+        distances[i] = totalDistance;
+        forces[i] = forceVector;
     }
 }
 
-void ZonePlacer::separateOverlappingZones(ZonesMap& zones,
-                                          ForceVector& forces,
-                                          DistanceVector& overlaps)
+void ZonePlacer::separateOverlappingZones(const Centers& centers,
+                                          Forces& forces,
+                                          Distances& overlaps) const
 {
-    for (auto& zone : zones) {
-        const auto& pos{zone.second->getCenter()};
+    for (std::size_t i = 0; i < centers.size(); ++i) {
+        const auto& pos{centers[i]};
+        const auto zoneSize{placedZones[i]->size};
         VPosition forceVector{};
         float overlap{};
 
         // Separate overlapping zones
-        for (auto& otherZone : zones) {
-            if (zone == otherZone) {
+        for (std::size_t j = 0; j < centers.size(); ++j) {
+            if (i == j) {
                 continue;
             }
 
-            const auto& otherZoneCenter{otherZone.second->getCenter()};
+            const auto& otherZoneCenter{centers[j]};
             const float distance{static_cast<float>(pos.distance(otherZoneCenter))};
-            const float minDistance{(zone.second->size + otherZone.second->size) / mapSize};
+            const float minDistance{(zoneSize + placedZones[j]->size) / mapSize};
 
             if (distance < minDistance) {
                 // Negative value
@@ -355,7 +513,7 @@ void ZonePlacer::separateOverlappingZones(ZonesMap& zones,
 
         // Move zones away from boundaries
         // do not scale boundary distance - zones tend to get squashed
-        const float size{zone.second->size / mapSize};
+        const float size{zoneSize / mapSize};
 
         auto pushAwayFromBoundary = [&forceVector, &pos, size, &overlap, this](float x, float y) {
             const VPosition boundary{x, y};
@@ -383,35 +541,37 @@ void ZonePlacer::separateOverlappingZones(ZonesMap& zones,
             pushAwayFromBoundary(pos.x, 1);
         }
 
-        overlaps[zone.second] = overlap;
-        forces[zone.second] = forceVector;
+        overlaps[i] = overlap;
+        forces[i] = forceVector;
     }
 }
 
-void ZonePlacer::moveOneZone(ZonesMap& zones,
-                             ForceVector& totalForces,
-                             DistanceVector& distances,
-                             DistanceVector& overlaps)
+void ZonePlacer::moveOneZone(Centers& centers,
+                             const Forces& totalForces,
+                             const Distances& distances,
+                             const Distances& overlaps) const
 {
+    constexpr std::size_t noZone{std::numeric_limits<std::size_t>::max()};
+
     // The more zones, the greater total distance expected
-    const int maxDistanceMovementRatio{static_cast<int>(zones.size() * zones.size())};
-    std::shared_ptr<TemplateZone> misplacedZone;
+    const int maxDistanceMovementRatio{static_cast<int>(centers.size() * centers.size())};
+    std::size_t misplacedZone{noZone};
     float maxRatio{};
     float totalDistance{};
     float totalOverlap{};
 
     // Find most misplaced zone
-    for (auto& zone : distances) {
-        totalDistance += zone.second;
+    for (std::size_t i = 0; i < centers.size(); ++i) {
+        totalDistance += distances[i];
 
-        const auto overlap{overlaps[zone.first]};
+        const auto overlap{overlaps[i]};
         totalOverlap += overlap;
 
-        const float ratio{(zone.second + overlap) / (float)totalForces[zone.first].mag()};
+        const float ratio{(distances[i] + overlap) / (float)totalForces[i].mag()};
         // If distance to actual movement is long, the zone is misplaced
         if (ratio > maxRatio) {
             maxRatio = ratio;
-            misplacedZone = zone.first;
+            misplacedZone = i;
         }
     }
 
@@ -419,77 +579,81 @@ void ZonePlacer::moveOneZone(ZonesMap& zones,
         std::cout << "Worst misplacement/movement ratio: " << maxRatio << '\n';
     }
 
-    if (!(maxRatio > maxDistanceMovementRatio && misplacedZone)) {
+    if (!(maxRatio > maxDistanceMovementRatio && misplacedZone != noZone)) {
         return;
     }
 
-    std::shared_ptr<TemplateZone> targetZone;
-    const auto& ourCenter{misplacedZone->getCenter()};
+    std::size_t targetZone{noZone};
+    const auto ourCenter{centers[misplacedZone]};
+    const auto ourSize{placedZones[misplacedZone]->size};
 
     if (totalDistance > totalOverlap) {
         // Find most distant zone that should be attracted and move inside it
         float maxDistance = 0;
-        for (auto& connection : misplacedZone->connections) {
-            auto otherZone = zones[connection];
-            const float distance{static_cast<float>(otherZone->getCenter().distSquared(ourCenter))};
+        for (const auto connection : zoneConnections[misplacedZone]) {
+            const float distance{static_cast<float>(centers[connection].distSquared(ourCenter))};
             if (distance > maxDistance) {
                 maxDistance = distance;
-                targetZone = otherZone;
+                targetZone = connection;
             }
         }
 
-        if (targetZone) {
-            const auto vec{targetZone->getCenter() - ourCenter};
-            const float newDistanceBetweenZones{std::max(misplacedZone->size, targetZone->size)
+        if (targetZone != noZone) {
+            const auto& targetCenter{centers[targetZone]};
+            const auto vec{targetCenter - ourCenter};
+            const float newDistanceBetweenZones{std::max(ourSize, placedZones[targetZone]->size)
                                                 / mapSize};
 
             if (mapGenerator->isDebugMode()) {
-                std::cout << "Trying to move zone " << misplacedZone->id << ' ' << ourCenter
-                          << " towards " << targetZone->id << ' ' << targetZone->getCenter()
-                          << ". Old distance " << maxDistance << "\nDirection is " << vec << '\n';
+                std::cout << "Trying to move zone " << placedZones[misplacedZone]->id << ' '
+                          << ourCenter << " towards " << placedZones[targetZone]->id << ' '
+                          << targetCenter << ". Old distance " << maxDistance
+                          << "\nDirection is " << vec << '\n';
             }
 
             // Zones should now overlap by half size
-            misplacedZone->setCenter(targetZone->getCenter()
-                                     - vec.unitVector() * newDistanceBetweenZones);
+            centers[misplacedZone] = (targetCenter - vec.unitVector() * newDistanceBetweenZones)
+                                         .wrapped();
 
             if (mapGenerator->isDebugMode()) {
-                std::cout << "New distance "
-                          << targetZone->getCenter().distance(misplacedZone->getCenter()) << '\n';
+                std::cout << "New distance " << targetCenter.distance(centers[misplacedZone])
+                          << '\n';
             }
         }
     } else {
         float maxOverlap{};
-        for (auto& otherZone : zones) {
-            if (otherZone.second == misplacedZone) {
+        for (std::size_t i = 0; i < centers.size(); ++i) {
+            if (i == misplacedZone) {
                 continue;
             }
 
-            const auto& otherZoneCenter = otherZone.second->getCenter();
-            const auto distance{static_cast<float>(otherZoneCenter.distSquared(ourCenter))};
+            const auto distance{static_cast<float>(centers[i].distSquared(ourCenter))};
             if (distance > maxOverlap) {
                 maxOverlap = distance;
-                targetZone = otherZone.second;
+                targetZone = i;
             }
         }
 
-        if (targetZone) {
-            const auto vec{ourCenter - targetZone->getCenter()};
-            const float newDistanceBetweenZones{(misplacedZone->size + targetZone->size) / mapSize};
+        if (targetZone != noZone) {
+            const auto& targetCenter{centers[targetZone]};
+            const auto vec{ourCenter - targetCenter};
+            const float newDistanceBetweenZones{(ourSize + placedZones[targetZone]->size)
+                                                / mapSize};
 
             if (mapGenerator->isDebugMode()) {
-                std::cout << "Trying to move zone " << misplacedZone->id << ' ' << ourCenter
-                          << " away from " << targetZone->id << ' ' << targetZone->getCenter()
-                          << ". Old distance " << maxOverlap << "\nDirection is " << vec << '\n';
+                std::cout << "Trying to move zone " << placedZones[misplacedZone]->id << ' '
+                          << ourCenter << " away from " << placedZones[targetZone]->id << ' '
+                          << targetCenter << ". Old distance " << maxOverlap
+                          << "\nDirection is " << vec << '\n';
             }
 
             // Zones should now be just separated
-            misplacedZone->setCenter(targetZone->getCenter()
-                                     + vec.unitVector() * newDistanceBetweenZones);
+            centers[misplacedZone] = (targetCenter + vec.unitVector() * newDistanceBetweenZones)
+                                         .wrapped();
 
             if (mapGenerator->isDebugMode()) {
-                std::cout << "New distance "
-                          << targetZone->getCenter().distance(misplacedZone->getCenter()) << '\n';
+                std::cout << "New distance " << targetCenter.distance(centers[misplacedZone])
+                          << '\n';
             }
         }
     }
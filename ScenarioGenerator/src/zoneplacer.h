@@ -23,14 +23,15 @@
 #include "templatezone.h"
 #include "vposition.h"
 #include "zoneoptions.h"
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <vector>
 
 namespace rsg {
 
 using ZonesMap = std::map<TemplateZoneId, std::shared_ptr<TemplateZone>>;
 using ZoneVector = std::vector<std::pair<TemplateZoneId, std::shared_ptr<TemplateZone>>>;
-using ForceVector = std::map<std::shared_ptr<TemplateZone>, VPosition>;
-using DistanceVector = std::map<std::shared_ptr<TemplateZone>, float>;
 
 class MapGenerator;
 class RandomGenerator;
@@ -42,21 +43,89 @@ public:
         : mapGenerator{mapGenerator}
     { }
 
+    // Runs force-directed placement from one or more random starting layouts.
+    // Additional runs are made in parallel, the best layout is chosen the same way for each seed
     void placeZones(RandomGenerator* random);
 
     void assignZones();
 
+    // Returns number of iterations made by the chosen placement run
+    int getIterations() const
+    {
+        return iterationsMade;
+    }
+
 private:
-    void prepareZones(ZonesMap& zones, ZoneVector& zonesVector, RandomGenerator* random);
+    // Values of a single placement run indexed the same way as placedZones
+    using Centers = std::vector<VPosition>;
+    using Forces = std::vector<VPosition>;
+    using Distances = std::vector<float>;
+
+    // Best zone centers found by a placement run
+    struct Layout
+    {
+        Centers centers;
+        float totalDistance{1e10f};
+        float totalOverlap{1e10f};
+        // Number of iterations made by the run
+        int iterations{};
+
+        // Returns true if specified totals have better fitness: product of distance and overlap
+        bool isImprovedBy(float distance, float overlap) const
+        {
+            if (totalDistance > 0.0f && totalOverlap > 0.0f) {
+                return distance * overlap < totalDistance * totalOverlap;
+            }
+
+            return distance + overlap < totalDistance + totalOverlap;
+        }
+
+        // Returns fitness value isImprovedBy compares, smaller is better
+        float getFitness() const
+        {
+            if (totalDistance > 0.0f && totalOverlap > 0.0f) {
+                return totalDistance * totalOverlap;
+            }
+
+            return totalDistance + totalOverlap;
+        }
+    };
+
+    // Zone positions and sizes stored as structure of arrays
+    struct ZoneArrays
+    {
+        std::vector<int> x;
+        std::vector<int> y;
+        std::vector<float> sizes;
+    };
 
-    void attractConnectedZones(ZonesMap& zones, ForceVector& forces, DistanceVector& distances);
+    // Labels each tile with index of zone that has the smallest 'distance(x, y, zoneIndex)'.
+    // Rows are labeled in parallel, see MapGenOptions::threads
+    template <typename F>
+    void labelTiles(const ZoneArrays& arrays, std::vector<std::uint32_t>& labels, F&& distance) const;
 
-    void separateOverlappingZones(ZonesMap& zones, ForceVector& forces, DistanceVector& overlaps);
+    // Returns number of threads for specified number of independent tasks
+    std::size_t getThreadsTotal(std::size_t tasksTotal) const;
 
-    void moveOneZone(ZonesMap& zones,
-                     ForceVector& totalForces,
-                     DistanceVector& distances,
-                     DistanceVector& overlaps);
+    void prepareZones(ZoneVector& zonesVector, Centers& centers, RandomGenerator* random);
+
+    // Places zones on circle at random angles
+    void createStartingLayout(Centers& centers, RandomGenerator& random) const;
+
+    // Simulates zones movement from specified centers, does not change zones themselves.
+    // Stops early when best fitness converges, see convergenceWindow
+    Layout runPlacement(Centers centers, int iterations) const;
+
+    void attractConnectedZones(const Centers& centers, Forces& forces, Distances& distances) const;
+
+    void separateOverlappingZones(const Centers& centers,
+                                  Forces& forces,
+                                  Distances& overlaps) const;
+
+    void moveOneZone(Centers& centers,
+                     const Forces& totalForces,
+                     const Distances& distances,
+                     const Distances& overlaps) const;
 
     Position coords(const VPosition& p) const;
 
@@ -68,6 +137,9 @@ private:
     }
 
     MapGenerator* mapGenerator{};
+    // Zones in identifier order and indices of their connections in it
+    std::vector<std::shared_ptr<TemplateZone>> placedZones;
+    std::vector<std::vector<std::size_t>> zoneConnections;
     int width{};
     int height{};
     // Metric coefficients
@@ -77,6 +149,13 @@ private:
 
     float gravityConstant{};
     float stiffnessConstant{};
+
+    // Number of iterations best fitness is checked over, 0 disables early termination
+    int convergenceWindow{};
+    // Placement stops if best fitness improves by less than this percent over the window
+    float convergenceThreshold{};
+    // Iterations made by the chosen placement run
+    int iterationsMade{};
 };
 
 } // namespace rsg
@@ -19,6 +19,7 @@
 
 #include "dbf.h"
 #include <charconv>
+#include <cstring>
 #include <fstream>
 
 namespace rsg {
@@ -172,9 +173,17 @@ bool Dbf::Record::value(bool& result, const Column& column) const
     return true;
 }
 
-Dbf::Dbf(const std::filesystem::path& filePath)
+Dbf::Dbf(const std::filesystem::path& filePath, Storage storage)
     : dbfFilePath{filePath}
 {
+    if (storage == Storage::Mapped) {
+        mappedFile = MappedFile{filePath};
+        if (mappedFile) {
+            valid = readContents(mappedFile.data(), mappedFile.size());
+            return;
+        }
+    }
+
     std::ifstream stream(filePath, std::ios_base::binary);
     if (!stream) {
         return;
@@ -184,49 +193,16 @@ Dbf::Dbf(const std::filesystem::path& filePath)
     const auto fileSize = stream.tellg();
     stream.seekg(0, stream.beg);
 
-    if (fileSize < sizeof(Header)) {
-        return;
-    }
-
-    if (!readHeader(stream)) {
-        return;
-    }
-
-    const auto recordsDataLength = recordsTotal() * header.recordLength;
-    const auto recordsEnd = header.headerLength + recordsDataLength;
-    if (recordsEnd + 1 != fileSize) {
-        return;
-    }
-
-    if (!readColumns(stream)) {
+    if (fileSize < 0) {
         return;
     }
 
-    char endOfFields{};
-    stream.read(&endOfFields, 1);
-
-    if (endOfFields != 0xd) {
+    fileData.resize(static_cast<std::size_t>(fileSize));
+    if (!stream.read(reinterpret_cast<char*>(fileData.data()), fileSize)) {
         return;
     }
 
-    recordsData.resize(recordsDataLength);
-
-    // https://en.wikipedia.org/wiki/.dbf#Database_records
-    // Each record begins with a 1-byte "deletion" flag. The byte's value is a space (0x20), if the
-    // record is active, or an asterisk (0x2A), if the record is deleted.
-    char firstChar{};
-    stream.read(&firstChar, 1);
-    if (firstChar != ' ' && firstChar != '*') {
-        // Workaround for different file formats from Sdbf/SergDBF where there is an additional
-        // EOF/NUL between header and data blocks
-        stream.read(reinterpret_cast<char*>(&recordsData[0]), recordsDataLength);
-    } else {
-        recordsData[0] = firstChar;
-        stream.read(reinterpret_cast<char*>(&recordsData[1]), recordsDataLength - 1);
-    }
-
-    valid = true;
-    return;
+    valid = readContents(fileData.data(), fileData.size());
 }
 
 std::uint32_t Dbf::columnsTotal() const
@@ -260,15 +236,64 @@ bool Dbf::record(Record& result, std::uint32_t index) const
         return false;
     }
 
-    const auto* bgn = &recordsData[index * header.recordLength];
+    const auto* bgn = recordsData + index * header.recordLength;
     result = Record(this, Record::Data(bgn, header.recordLength));
     return true;
 }
 
-bool Dbf::readHeader(std::ifstream& stream)
+bool Dbf::readContents(const std::uint8_t* contents, std::size_t contentsSize)
+{
+    if (contentsSize < sizeof(Header)) {
+        return false;
+    }
+
+    if (!readHeader(contents)) {
+        return false;
+    }
+
+    const std::size_t recordsDataLength = recordsTotal() * header.recordLength;
+    const auto recordsEnd = header.headerLength + recordsDataLength;
+    if (recordsEnd + 1 != contentsSize) {
+        return false;
+    }
+
+    if (!readColumns(contents)) {
+        return false;
+    }
+
+    // Columns are followed by terminator and then records
+    const auto endOfFieldsOffset = sizeof(Header) + columns.size() * sizeof(Column);
+    if (endOfFieldsOffset + 1 >= contentsSize) {
+        return false;
+    }
+
+    if (contents[endOfFieldsOffset] != 0xd) {
+        return false;
+    }
+
+    // https://en.wikipedia.org/wiki/.dbf#Database_records
+    // Each record begins with a 1-byte "deletion" flag. The byte's value is a space (0x20), if the
+    // record is active, or an asterisk (0x2A), if the record is deleted.
+    auto recordsOffset = endOfFieldsOffset + 1;
+    const auto firstChar = contents[recordsOffset];
+    if (firstChar != ' ' && firstChar != '*') {
+        // Workaround for different file formats from Sdbf/SergDBF where there is an additional
+        // EOF/NUL between header and data blocks
+        ++recordsOffset;
+    }
+
+    if (recordsOffset + recordsDataLength > contentsSize) {
+        return false;
+    }
+
+    recordsData = contents + recordsOffset;
+    return true;
+}
+
+bool Dbf::readHeader(const std::uint8_t* contents)
 {
     Header tmpHeader;
-    stream.read(reinterpret_cast<char*>(&tmpHeader), sizeof(tmpHeader));
+    std::memcpy(&tmpHeader, contents, sizeof(tmpHeader));
 
     if (tmpHeader.version.parts.version != 0x3) {
         return false;
@@ -286,19 +311,18 @@ bool Dbf::readHeader(std::ifstream& stream)
     return true;
 }
 
-bool Dbf::readColumns(std::ifstream& stream)
+bool Dbf::readColumns(const std::uint8_t* contents)
 {
+    // Header length is checked against contents size, all columns are inside
     const auto columnsTotal = (header.headerLength - sizeof(Header) - 1) / sizeof(Column);
     Columns tmpColumns(columnsTotal);
     ColumnIndexMap tmpIndices;
 
+    std::memcpy(tmpColumns.data(), contents + sizeof(Header), columnsTotal * sizeof(Column));
+
     std::uint32_t index{0};
     std::uint32_t dataAddress{0};
     for (auto& column : tmpColumns) {
-        if (!readColumn(stream, column)) {
-            return false;
-        }
-
         column.dataAddress = dataAddress;
         dataAddress += column.length;
         tmpIndices[column.name] = index++;
@@ -309,10 +333,4 @@ bool Dbf::readColumns(std::ifstream& stream)
     return true;
 }
 
-bool Dbf::readColumn(std::ifstream& stream, Column& column)
-{
-    stream.read(reinterpret_cast<char*>(&column), sizeof(Column));
-    return true;
-}
-
 } // namespace rsg
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include "mappedfile.h"
 #include <cstdint>
 #include <filesystem>
 #include <gsl/span>
@@ -26,6 +27,7 @@
 #include <map>
 #include <optional>
 #include <string_view>
+#include <type_traits>
 #include <vector>
 
 namespace rsg {
@@ -80,6 +82,51 @@ public:
 
     static_assert(sizeof(Column) == 32, "Size of Column structure must be exactly 32 bytes");
 
+    // How database file contents are kept while Dbf object is alive
+    enum class Storage
+    {
+        Memory, /**< File is read into memory. */
+        Mapped, /**< File is mapped into memory, records are accessed without copying. */
+    };
+
+    /**
+     * Column bound by name once per table.
+     * Records read values through it without looking up columns by name.
+     */
+    template <typename T>
+    class Field
+    {
+    public:
+        Field() = default;
+
+        /** Returns false if column is missing or its type does not match T. */
+        operator bool() const
+        {
+            return column != nullptr;
+        }
+
+        const char* name() const
+        {
+            return columnName;
+        }
+
+        const Column* get() const
+        {
+            return column;
+        }
+
+    private:
+        friend Dbf;
+
+        Field(const char* columnName, const Column* column)
+            : columnName{columnName}
+            , column{column}
+        { }
+
+        const char* columnName{};
+        const Column* column{};
+    };
+
     class Record
     {
     public:
@@ -106,6 +153,13 @@ public:
         bool value(bool& result, const char* columnName) const;
         bool value(bool& result, const Column& column) const;
 
+        // Bound fields access
+        template <typename T>
+        bool value(T& result, const Field<T>& field) const
+        {
+            return field && value(result, *field.get());
+        }
+
         bool deleted() const
         {
             return data[0] == '*';
@@ -137,7 +191,7 @@ public:
         value_type operator*() const
         {
             const auto length{dbf->header.recordLength};
-            const auto ptr = &dbf->recordsData[index * length];
+            const auto ptr = dbf->recordsData + index * length;
 
             return value_type{dbf, Record::Data{ptr, length}};
         }
@@ -174,7 +228,12 @@ public:
         std::uint32_t index;
     };
 
-    Dbf(const std::filesystem::path& filePath);
+    // Falls back to Storage::Memory if file can not be mapped
+    Dbf(const std::filesystem::path& filePath, Storage storage = Storage::Mapped);
+
+    // Records point into contents owned by the object
+    Dbf(const Dbf&) = delete;
+    Dbf& operator=(const Dbf&) = delete;
 
     operator bool() const
     {
@@ -190,6 +249,22 @@ public:
     /** Returns nullptr if column with specified name can not be found. */
     const Column* column(const char* name) const;
 
+    /**
+     * Binds column with specified name for typed access.
+     * Supported types are std::string_view for characters, int for numbers and bool for logicals.
+     * @returns invalid field if column is missing or has different type.
+     */
+    template <typename T>
+    Field<T> field(const char* name) const
+    {
+        const Column* bound{column(name)};
+        if (bound && bound->type != columnType<T>()) {
+            bound = nullptr;
+        }
+
+        return Field<T>{name, bound};
+    }
+
     /**
      * Creates thin wrapper for record data access.
      * Created records must not outlive DbfFile object that created them.
@@ -272,17 +347,32 @@ private:
         }
     };
 
+    template <typename T>
+    static constexpr Column::Type columnType()
+    {
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            return Column::Type::Character;
+        } else if constexpr (std::is_same_v<T, int>) {
+            return Column::Type::Number;
+        } else {
+            static_assert(std::is_same_v<T, bool>, "Unsupported field type");
+            return Column::Type::Logical;
+        }
+    }
+
     using Columns = std::vector<Column>;
     using ColumnIndexMap = std::map<const char*, std::uint32_t, CompareKeys>;
 
-    bool readHeader(std::ifstream& stream);
-    bool readColumns(std::ifstream& stream);
-    bool readColumn(std::ifstream& stream, Column& column);
+    bool readContents(const std::uint8_t* contents, std::size_t contentsSize);
+    bool readHeader(const std::uint8_t* contents);
+    bool readColumns(const std::uint8_t* contents);
 
     Header header{};
     Columns columns;
     ColumnIndexMap columnIndices;
-    std::vector<std::uint8_t> recordsData;
+    MappedFile mappedFile;
+    std::vector<std::uint8_t> fileData; // Used when file is not mapped
+    const std::uint8_t* recordsData{};  // Points into mapped file or file data
     std::filesystem::path dbfFilePath;
     bool valid{};
 };
@@ -0,0 +1,372 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gameinfocache.h"
+#include "generatorsettings.h"
+#include "privatefiles.h"
+#include <algorithm>
+#include <cstdio>
+#include <system_error>
+
+namespace rsg {
+
+// Increase each time cache contents change
+static constexpr std::uint32_t cacheFormatVersion{3};
+
+static constexpr char cacheSignature[8] = {'D', '2', 'R', 'S', 'G', 'G', 'I', 'C'};
+
+struct CacheHeader
+{
+    char signature[8];
+    std::uint32_t formatVersion;
+    std::uint32_t reserved;
+    std::uint64_t key;
+    std::uint64_t contentsSize;
+};
+
+// Game files read by StandaloneGameInfo and readGeneratorSettings(), relative to game folder
+// clang-format off
+static const char* sourceFiles[] = {
+    "Globals/LAttR.dbf",
+    "Globals/GAttacks.dbf",
+    "Globals/GUnits.dbf",
+    "Globals/GItem.dbf",
+    "Globals/GSpells.dbf",
+    "Globals/GLmark.dbf",
+    "Globals/Tleader.dbf",
+    "Globals/Grace.dbf",
+    "Globals/Tglobal.dbf",
+    "Interf/TAppEdit.dbf",
+    "ScenData/Cityname.dbf",
+    "ScenData/Campname.dbf",
+    "ScenData/Magename.dbf",
+    "ScenData/Mercname.dbf",
+    "ScenData/Ruinname.dbf",
+    "ScenData/Trainame.dbf",
+    "Scripts/generatorSettings.lua",
+    "Imgs/IsoTerrn.ff",
+    "Imgs/IsoCmon.ff"
+};
+// clang-format on
+
+// FNV-1a
+static void hashBytes(std::uint64_t& hash, const void* data, std::size_t byteCount)
+{
+    const auto bytes{static_cast<const unsigned char*>(data)};
+
+    for (std::size_t i = 0; i < byteCount; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+}
+
+template <typename T>
+static void hashValue(std::uint64_t& hash, const T& value)
+{
+    hashBytes(hash, &value, sizeof(value));
+}
+
+std::filesystem::path getGameInfoCachePath(const std::filesystem::path& cacheFolder,
+                                           const std::filesystem::path& gameFolderPath)
+{
+    std::uint64_t hash{0xcbf29ce484222325ull};
+
+    std::error_code error;
+    const auto folder{std::filesystem::absolute(gameFolderPath, error).u8string()};
+    hashBytes(hash, folder.data(), folder.size());
+
+    char name[32]{};
+    std::snprintf(name, sizeof(name), "gameinfo-%016llx.cache",
+                  static_cast<unsigned long long>(hash));
+
+    return cacheFolder / name;
+}
+
+std::uint64_t computeGameInfoCacheKey(const std::filesystem::path& gameFolderPath)
+{
+    std::uint64_t hash{0xcbf29ce484222325ull};
+
+    hashValue(hash, cacheFormatVersion);
+
+    std::error_code error;
+    const auto folder{std::filesystem::absolute(gameFolderPath, error).u8string()};
+    hashBytes(hash, folder.data(), folder.size());
+
+    for (const char* fileName : sourceFiles) {
+        const auto filePath{gameFolderPath / fileName};
+
+        // Missing files are hashed as zero size and time, game info can not be read anyway
+        const auto size{std::filesystem::file_size(filePath, error)};
+        hashValue(hash, error ? std::uintmax_t{0} : size);
+
+        const auto time{std::filesystem::last_write_time(filePath, error)};
+        hashValue(hash, error ? std::int64_t{0}
+                              : static_cast<std::int64_t>(time.time_since_epoch().count()));
+    }
+
+    return hash;
+}
+
+static std::uint32_t readUint32(const char* bytes)
+{
+    std::uint32_t value{};
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+void TextTable::assign(const TextsInfo& texts)
+{
+    std::vector<const TextsInfo::value_type*> sorted;
+    sorted.reserve(texts.size());
+
+    std::size_t stringsSize{};
+    for (const auto& text : texts) {
+        sorted.push_back(&text);
+        stringsSize += text.second.size() + 1;
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [](const auto* first, const auto* second) {
+        return first->first.getValue() < second->first.getValue();
+    });
+
+    const auto total{static_cast<std::uint32_t>(sorted.size())};
+    const std::size_t indexSize{sizeof(total) + std::size_t{total} * recordSize};
+
+    buffer.assign(indexSize + stringsSize, '\0');
+    std::memcpy(buffer.data(), &total, sizeof(total));
+
+    char* record{buffer.data() + sizeof(total)};
+    std::uint32_t offset{};
+
+    for (const auto* text : sorted) {
+        const std::uint32_t id{text->first.getValue()};
+        std::memcpy(record, &id, sizeof(id));
+        std::memcpy(record + sizeof(id), &offset, sizeof(offset));
+        record += recordSize;
+
+        // Zero terminators are already there
+        std::memcpy(buffer.data() + indexSize + offset, text->second.data(), text->second.size());
+        offset += static_cast<std::uint32_t>(text->second.size() + 1);
+    }
+
+    tableData = buffer.data();
+    tableSize = buffer.size();
+    count = total;
+}
+
+void TextTable::view(const char* data, std::size_t size)
+{
+    if (size < sizeof(std::uint32_t)) {
+        throw std::runtime_error("Game info cache has truncated text table");
+    }
+
+    const std::uint32_t total{readUint32(data)};
+    const std::size_t indexSize{sizeof(total) + std::size_t{total} * recordSize};
+    if (size < indexSize) {
+        throw std::runtime_error("Game info cache has truncated text table");
+    }
+
+    // Each string must start and end inside the table, so lookups never read past it
+    const std::size_t stringsSize{size - indexSize};
+    if (total && (!stringsSize || data[size - 1] != '\0')) {
+        throw std::runtime_error("Game info cache has unterminated text");
+    }
+
+    for (std::uint32_t i = 0; i < total; ++i) {
+        const char* record{data + sizeof(total) + std::size_t{i} * recordSize};
+
+        if (readUint32(record + sizeof(std::uint32_t)) >= stringsSize) {
+            throw std::runtime_error("Game info cache has wrong text offset");
+        }
+    }
+
+    buffer.clear();
+    tableData = data;
+    tableSize = size;
+    count = total;
+}
+
+const char* TextTable::find(const CMidgardID& id) const
+{
+    if (!count) {
+        return nullptr;
+    }
+
+    const std::uint32_t value{id.getValue()};
+    const char* records{tableData + sizeof(std::uint32_t)};
+
+    std::size_t first{};
+    std::size_t last{count};
+
+    while (first < last) {
+        const std::size_t middle{first + (last - first) / 2};
+        const char* record{records + middle * recordSize};
+        const std::uint32_t recordId{readUint32(record)};
+
+        if (recordId < value) {
+            first = middle + 1;
+        } else if (value < recordId) {
+            last = middle;
+        } else {
+            const char* strings{records + std::size_t{count} * recordSize};
+            return strings + readUint32(record + sizeof(std::uint32_t));
+        }
+    }
+
+    return nullptr;
+}
+
+std::optional<GameInfoCache> readGameInfoCache(const std::filesystem::path& cacheFilePath,
+                                               std::uint64_t key)
+{
+    GameInfoCache cache{MappedFile{cacheFilePath}};
+    if (!cache.file || cache.file.size() < sizeof(CacheHeader)) {
+        return std::nullopt;
+    }
+
+    CacheHeader header{};
+    std::memcpy(&header, cache.file.data(), sizeof(header));
+
+    if (std::memcmp(header.signature, cacheSignature, sizeof(cacheSignature))
+        || header.formatVersion != cacheFormatVersion || header.key != key
+        || header.contentsSize != cache.file.size() - sizeof(header)) {
+        return std::nullopt;
+    }
+
+    cache.contents = reinterpret_cast<const char*>(cache.file.data()) + sizeof(header);
+    cache.contentsSize = static_cast<std::size_t>(header.contentsSize);
+
+    return cache;
+}
+
+void writeGameInfoCache(const std::filesystem::path& cacheFilePath,
+                        std::uint64_t key,
+                        const CacheWriter& writer)
+{
+    const auto& contents{writer.getData()};
+
+    CacheHeader header{};
+    std::memcpy(header.signature, cacheSignature, sizeof(cacheSignature));
+    header.formatVersion = cacheFormatVersion;
+    header.key = key;
+    header.contentsSize = contents.size();
+
+    std::string data(sizeof(header) + contents.size(), '\0');
+    std::memcpy(data.data(), &header, sizeof(header));
+    std::memcpy(data.data() + sizeof(header), contents.data(), contents.size());
+
+    // Other processes never see partially written cache
+    if (!replaceFile(cacheFilePath, data)) {
+        throw std::runtime_error("Could not write game info cache " + cacheFilePath.string());
+    }
+}
+
+static void writeImages(CacheWriter& writer, const GeneratorSettings::ObjectImages& images)
+{
+    writer.write(images.images);
+    writer.write(images.waterImages);
+}
+
+static void readImages(CacheReader& reader, GeneratorSettings::ObjectImages& images)
+{
+    reader.read(images.images);
+    reader.read(images.waterImages);
+}
+
+void writeGeneratorSettings(CacheWriter& writer, const GeneratorSettings& settings)
+{
+    writer.write(settings.forbiddenUnits);
+    writer.write(settings.forbiddenItems);
+    writer.write(settings.forbiddenSpells);
+
+    const auto& landmarks{settings.landmarks};
+    writer.write(landmarks.empire);
+    writer.write(landmarks.clans);
+    writer.write(landmarks.undead);
+    writer.write(landmarks.legions);
+    writer.write(landmarks.elves);
+    writer.write(landmarks.neutral);
+    writer.write(landmarks.mountains);
+
+    writer.write(static_cast<std::uint32_t>(settings.mountains.size()));
+    for (const auto& mountain : settings.mountains) {
+        writer.write(mountain.size);
+        writer.write(mountain.image);
+    }
+
+    writeImages(writer, settings.bags);
+    writeImages(writer, settings.ruins);
+    writeImages(writer, settings.merchants);
+    writeImages(writer, settings.mages);
+    writeImages(writer, settings.trainers);
+    writeImages(writer, settings.mercenaries);
+    writeImages(writer, settings.resourceMarkets);
+
+    writer.write(settings.maxTreeImageIndex);
+    writer.write(settings.iterations);
+    writer.write(settings.templateInstructionLimit);
+    writer.write(settings.templateMemoryLimit);
+    writer.write(settings.maxTemplateCustomParameters);
+    writer.write(settings.enableParameterForest);
+    writer.write(settings.enableParameterRoads);
+    writer.write(settings.enableParameterGold);
+    writer.write(settings.enableParameterMana);
+}
+
+void readGeneratorSettings(CacheReader& reader, GeneratorSettings& settings)
+{
+    reader.read(settings.forbiddenUnits);
+    reader.read(settings.forbiddenItems);
+    reader.read(settings.forbiddenSpells);
+
+    auto& landmarks{settings.landmarks};
+    reader.read(landmarks.empire);
+    reader.read(landmarks.clans);
+    reader.read(landmarks.undead);
+    reader.read(landmarks.legions);
+    reader.read(landmarks.elves);
+    reader.read(landmarks.neutral);
+    reader.read(landmarks.mountains);
+
+    settings.mountains.resize(reader.readSize(2 * sizeof(int)));
+    for (auto& mountain : settings.mountains) {
+        reader.read(mountain.size);
+        reader.read(mountain.image);
+    }
+
+    readImages(reader, settings.bags);
+    readImages(reader, settings.ruins);
+    readImages(reader, settings.merchants);
+    readImages(reader, settings.mages);
+    readImages(reader, settings.trainers);
+    readImages(reader, settings.mercenaries);
+    readImages(reader, settings.resourceMarkets);
+
+    reader.read(settings.maxTreeImageIndex);
+    reader.read(settings.iterations);
+    reader.read(settings.templateInstructionLimit);
+    reader.read(settings.templateMemoryLimit);
+    reader.read(settings.maxTemplateCustomParameters);
+    reader.read(settings.enableParameterForest);
+    reader.read(settings.enableParameterRoads);
+    reader.read(settings.enableParameterGold);
+    reader.read(settings.enableParameterMana);
+}
+
+} // namespace rsg
@@ -0,0 +1,296 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "gameinfo.h"
+#include "mappedfile.h"
+#include "rsgid.h"
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace rsg {
+
+struct GeneratorSettings;
+
+// Texts sorted by id in a single buffer, so they can be used right from a mapped cache.
+// Layout: uint32 count, count records of uint32 id and uint32 offset of a string,
+// then zero terminated strings. Values use native byte order like the rest of the cache
+class TextTable
+{
+public:
+    TextTable() = default;
+
+    // Table can refer to its own buffer
+    TextTable(const TextTable&) = delete;
+    TextTable& operator=(const TextTable&) = delete;
+
+    TextTable(TextTable&&) = default;
+    TextTable& operator=(TextTable&&) = default;
+
+    // Builds table that owns its data
+    void assign(const TextsInfo& texts);
+    // Uses table stored in data without copying, data must outlive the table.
+    // Throws std::runtime_error if table is malformed
+    void view(const char* data, std::size_t size);
+
+    // Returns zero terminated text or nullptr if there is no text with such id
+    const char* find(const CMidgardID& id) const;
+
+    const char* data() const
+    {
+        return tableData;
+    }
+
+    std::size_t size() const
+    {
+        return tableSize;
+    }
+
+private:
+    static constexpr std::size_t recordSize{2 * sizeof(std::uint32_t)};
+
+    std::vector<char> buffer;
+    const char* tableData{};
+    std::size_t tableSize{};
+    std::uint32_t count{};
+};
+
+// Appends values to game info cache in native byte order.
+// Cache is read by the same build that wrote it, so no conversions needed
+class CacheWriter
+{
+public:
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+    void write(T value)
+    {
+        const auto bytes{reinterpret_cast<const char*>(&value)};
+        data.insert(data.end(), bytes, bytes + sizeof(value));
+    }
+
+    // Booleans take a single byte regardless of platform
+    void write(bool value)
+    {
+        write(static_cast<std::uint8_t>(value));
+    }
+
+    void write(const CMidgardID& id)
+    {
+        write(id.getValue());
+    }
+
+    void write(const std::string& string)
+    {
+        write(static_cast<std::uint32_t>(string.size()));
+        data.insert(data.end(), string.begin(), string.end());
+    }
+
+    template <typename T>
+    void write(const std::vector<T>& values)
+    {
+        write(static_cast<std::uint32_t>(values.size()));
+        for (const auto& value : values) {
+            write(value);
+        }
+    }
+
+    void write(const TextTable& table)
+    {
+        write(static_cast<std::uint32_t>(table.size()));
+        data.insert(data.end(), table.data(), table.data() + table.size());
+    }
+
+    template <typename T>
+    void write(const std::set<T>& values)
+    {
+        write(static_cast<std::uint32_t>(values.size()));
+        for (const auto& value : values) {
+            write(value);
+        }
+    }
+
+    const std::vector<char>& getData() const
+    {
+        return data;
+    }
+
+private:
+    std::vector<char> data;
+};
+
+// Reads values written by CacheWriter, throws std::runtime_error if data ends unexpectedly
+// or has values that CacheWriter could not write.
+// Text tables are not copied and refer to the data
+class CacheReader
+{
+public:
+    CacheReader(const char* data, std::size_t size)
+        : current{data}
+        , end{data + size}
+    { }
+
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+    void read(T& value)
+    {
+        std::memcpy(&value, take(sizeof(value)), sizeof(value));
+    }
+
+    void read(bool& value)
+    {
+        const auto byte{read<std::uint8_t>()};
+        if (byte > 1) {
+            throw std::runtime_error("Game info cache has wrong boolean value");
+        }
+
+        value = byte != 0;
+    }
+
+    void read(CMidgardID& id)
+    {
+        std::uint32_t value{};
+        read(value);
+        id = CMidgardID{value};
+    }
+
+    void read(std::string& string)
+    {
+        const auto length{readSize()};
+        string.assign(take(length), length);
+    }
+
+    template <typename T>
+    void read(std::vector<T>& values)
+    {
+        values.resize(readSize(getMinimumSize<T>()));
+        for (auto& value : values) {
+            read(value);
+        }
+    }
+
+    void read(TextTable& table)
+    {
+        const auto size{readSize()};
+        table.view(take(size), size);
+    }
+
+    template <typename T>
+    void read(std::set<T>& values)
+    {
+        values.clear();
+
+        const auto total{readSize(getMinimumSize<T>())};
+        for (std::uint32_t i = 0; i < total; ++i) {
+            T value{};
+            read(value);
+            // Values were written in order
+            values.insert(values.end(), value);
+        }
+    }
+
+    template <typename T>
+    T read()
+    {
+        T value{};
+        read(value);
+        return value;
+    }
+
+    // Reads number of elements that take at least elementSize bytes each.
+    // Throws if the rest of data can not hold them, so wrong sizes never cause huge allocations
+    std::uint32_t readSize(std::size_t elementSize = 1)
+    {
+        const auto size{read<std::uint32_t>()};
+        if (std::uint64_t{size} * elementSize > static_cast<std::size_t>(end - current)) {
+            throw std::runtime_error("Game info cache is truncated");
+        }
+
+        return size;
+    }
+
+    bool atEnd() const
+    {
+        return current == end;
+    }
+
+private:
+    // Returns smallest number of bytes a value of type T takes in the cache
+    template <typename T>
+    static constexpr std::size_t getMinimumSize()
+    {
+        if constexpr (std::is_arithmetic<T>::value) {
+            return sizeof(T);
+        }
+
+        // Ids are stored as integers, strings and containers start with their size
+        return sizeof(std::uint32_t);
+    }
+
+    const char* take(std::size_t byteCount)
+    {
+        if (static_cast<std::size_t>(end - current) < byteCount) {
+            throw std::runtime_error("Game info cache is truncated");
+        }
+
+        const char* bytes{current};
+        current += byteCount;
+        return bytes;
+    }
+
+    const char* current;
+    const char* end;
+};
+
+// Returns path of cache file for specified game folder inside cache folder,
+// so caches of different game folders do not replace each other
+std::filesystem::path getGameInfoCachePath(const std::filesystem::path& cacheFolder,
+                                           const std::filesystem::path& gameFolderPath);
+
+// Computes key of game data: hash of sizes and modification times
+// of all game files that are read by standalone generator, including game folder path
+std::uint64_t computeGameInfoCacheKey(const std::filesystem::path& gameFolderPath);
+
+// Game info cache file mapped into memory
+struct GameInfoCache
+{
+    MappedFile file;
+    // Contents without header, point into the mapped file
+    const char* contents{};
+    std::size_t contentsSize{};
+};
+
+// Maps cache file if it exists and was created for specified key
+std::optional<GameInfoCache> readGameInfoCache(const std::filesystem::path& cacheFilePath,
+                                               std::uint64_t key);
+// Replaces cache file at once, new file is readable by current user only.
+// Throws std::runtime_error if cache could not be written
+void writeGameInfoCache(const std::filesystem::path& cacheFilePath,
+                        std::uint64_t key,
+                        const CacheWriter& writer);
+
+void writeGeneratorSettings(CacheWriter& writer, const GeneratorSettings& settings);
+void readGeneratorSettings(CacheReader& reader, GeneratorSettings& settings);
+
+} // namespace rsg
@@ -0,0 +1,383 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "generatorserver.h"
+#include "batchgenerator.h"
+#include "bytesink.h"
+#include "exceptions.h"
+#include "luastatepool.h"
+#include "mapgenerator.h"
+#include "maptemplate.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sol/sol.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace rsg {
+
+static RaceType readRace(const std::string& name)
+{
+    // clang-format off
+    static const std::pair<const char*, RaceType> races[] = {
+        {"Human", RaceType::Human},
+        {"Undead", RaceType::Undead},
+        {"Heretic", RaceType::Heretic},
+        {"Dwarf", RaceType::Dwarf},
+        {"Elf", RaceType::Elf},
+        {"Random", RaceType::Random}
+    };
+    // clang-format on
+
+    for (const auto& [raceName, race] : races) {
+        if (name == raceName) {
+            return race;
+        }
+    }
+
+    throw std::runtime_error("Unknown race '" + name + "'");
+}
+
+std::vector<RaceType> readRaces(const std::string& list)
+{
+    std::vector<RaceType> races;
+
+    std::stringstream stream{list};
+    std::string name;
+    while (std::getline(stream, name, ',')) {
+        races.push_back(readRace(name));
+    }
+
+    return races;
+}
+
+// Reads comma separated list of custom parameter values
+static std::vector<int> readParameters(const std::string& list)
+{
+    std::vector<int> values;
+
+    std::stringstream stream{list};
+    std::string value;
+    while (std::getline(stream, value, ',')) {
+        values.push_back(std::stoi(value));
+    }
+
+    return values;
+}
+
+struct ServerRequest
+{
+    std::string id;
+    std::filesystem::path templatePath;
+    std::vector<RaceType> races;
+    std::vector<int> parameters;
+    std::time_t seed{};
+    int size{};
+    bool hasParameters{};
+};
+
+// Requests read from input waiting for workers.
+// Reader blocks when queue is full so memory use stays bounded
+class RequestQueue
+{
+public:
+    RequestQueue(std::size_t capacity)
+        : capacity{std::max<std::size_t>(capacity, 1)}
+    { }
+
+    void push(std::string line)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this]() { return lines.size() < capacity; });
+
+        lines.push_back(std::move(line));
+        notEmpty.notify_one();
+    }
+
+    // Returns false when queue is closed and there are no more requests
+    bool pop(std::string& line)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this]() { return !lines.empty() || closed; });
+
+        if (lines.empty()) {
+            return false;
+        }
+
+        line = std::move(lines.front());
+        lines.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<std::string> lines;
+    std::size_t capacity;
+    bool closed{};
+};
+
+static ServerRequest readRequest(const std::string& line)
+{
+    std::vector<std::string> fields;
+
+    std::stringstream stream{line};
+    std::string field;
+    while (std::getline(stream, field, '\t')) {
+        fields.push_back(field);
+    }
+
+    if (fields.size() < 5 || fields.size() > 6) {
+        throw std::runtime_error("Request must have 5 or 6 tab separated fields");
+    }
+
+    ServerRequest request;
+    request.id = fields[0];
+    request.templatePath = fields[1];
+    request.size = std::stoi(fields[2]);
+    request.races = readRaces(fields[3]);
+    request.seed = static_cast<std::time_t>(std::stoll(fields[4]));
+
+    if (fields.size() == 6) {
+        request.parameters = readParameters(fields[5]);
+        request.hasParameters = true;
+    }
+
+    return request;
+}
+
+// Responses are written to stdout, keep template output away from them
+static void redirectPrint(sol::state& lua)
+{
+    lua.script(R"(
+        print = function(...)
+            local args = table.pack(...)
+            for i = 1, args.n do
+                io.stderr:write(i > 1 and '\t' or '', tostring(args[i]))
+            end
+            io.stderr:write('\n')
+        end
+    )");
+}
+
+static void applyRequest(MapTemplateSettings& settings, const ServerRequest& request)
+{
+    if (request.size < settings.sizeMin || request.size > settings.sizeMax) {
+        std::stringstream stream;
+        stream << "Scenario size " << request.size << " is not supported by template '"
+               << settings.name << "', expected size in range [" << settings.sizeMin << " : "
+               << settings.sizeMax << "]";
+        throw TemplateException(stream.str());
+    }
+
+    if (static_cast<int>(request.races.size()) > settings.maxPlayers) {
+        std::stringstream stream;
+        stream << "Too many races specified, template '" << settings.name << "' allows up to "
+               << settings.maxPlayers << " players";
+        throw TemplateException(stream.str());
+    }
+
+    if (request.hasParameters && request.parameters.size() != settings.parameters.size()) {
+        std::stringstream stream;
+        stream << "Template '" << settings.name << "' has " << settings.parameters.size()
+               << " custom parameters, got " << request.parameters.size() << " values";
+        throw TemplateException(stream.str());
+    }
+
+    settings.size = request.size;
+    settings.races = request.races;
+    // Players not chosen explicitly get random races
+    settings.races.resize(settings.maxPlayers, RaceType::Random);
+
+    if (request.hasParameters) {
+        settings.parametersValues = request.parameters;
+    }
+}
+
+void runGeneratorServer(std::istream& input, std::ostream& output, const ServerOptions& options)
+{
+    std::size_t threadsTotal{options.threads};
+    if (!threadsTotal) {
+        threadsTotal = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    RequestQueue queue{options.queueSize};
+    std::mutex outputMutex;
+
+    // Lua states with executed templates shared by workers, most recently used first.
+    // Pools are shared with workers, so dropped pool lives until its leases are returned
+    using Pool = std::pair<std::filesystem::path, std::shared_ptr<LuaStatePool>>;
+    std::list<Pool> pools;
+    std::mutex poolsMutex;
+
+    LuaStatePoolOptions poolOptions;
+    poolOptions.setup = redirectPrint;
+    poolOptions.memoryLimit = options.luaMemoryLimit;
+    poolOptions.discardStates = !options.reuseStates;
+
+    const std::size_t poolsTotal{std::max<std::size_t>(options.templatePools, 1)};
+
+    auto getPool = [&pools, &poolsMutex, &poolOptions,
+                    poolsTotal](const std::filesystem::path& templatePath) {
+        std::lock_guard<std::mutex> lock(poolsMutex);
+
+        auto it{std::find_if(pools.begin(), pools.end(), [&templatePath](const Pool& pool) {
+            return pool.first == templatePath;
+        })};
+        if (it != pools.end()) {
+            pools.splice(pools.begin(), pools, it);
+            return pools.front().second;
+        }
+
+        pools.emplace_front(templatePath,
+                            std::make_shared<LuaStatePool>(templatePath, poolOptions));
+
+        // Drop states of least recently used templates
+        while (pools.size() > poolsTotal) {
+            pools.pop_back();
+        }
+
+        return pools.front().second;
+    };
+
+    auto writeError = [&output, &outputMutex](const std::string& id, std::string error) {
+        // Keep response on a single line
+        std::replace(error.begin(), error.end(), '\n', ' ');
+        std::replace(error.begin(), error.end(), '\r', ' ');
+
+        std::lock_guard<std::mutex> lock(outputMutex);
+        output << id << "\terror\t" << error << '\n';
+        output.flush();
+    };
+
+    auto worker = [&options, &queue, &output, &outputMutex, &writeError, &getPool,
+                   threadsTotal]() {
+        using Clock = std::chrono::steady_clock;
+        using Milliseconds = std::chrono::duration<double, std::milli>;
+
+        std::string line;
+
+        while (queue.pop(line)) {
+            std::string id{line.substr(0, line.find('\t'))};
+
+            try {
+                const auto request{readRequest(line)};
+                const auto start{Clock::now()};
+
+                MapTemplate mapTemplate;
+                std::unique_ptr<MapGenerator> generator;
+
+                {
+                    const auto pool{getPool(request.templatePath)};
+                    // State is returned as soon as contents are read
+                    auto lease{pool->acquire()};
+
+                    mapTemplate.settings = lease.getSettings();
+                    applyRequest(mapTemplate.settings, request);
+
+                    MapGenOptions genOptions{
+                        createMapGenOptions(mapTemplate, request.seed, options.randomEngine)};
+                    // Requests already run in parallel
+                    genOptions.threads = threadsTotal > 1 ? 1 : 0;
+                    generator = std::make_unique<MapGenerator>(genOptions, request.seed);
+
+                    readScenarioContents(*generator, mapTemplate, lease.getLua());
+                }
+
+                const auto templateReady{Clock::now()};
+                auto map{generator->generate()};
+                const auto generated{Clock::now()};
+
+                MemorySink sink;
+                map->serialize(sink);
+                const auto serialized{Clock::now()};
+
+                const auto& data{sink.getData()};
+
+                std::lock_guard<std::mutex> lock(outputMutex);
+                output << id << "\tok\t" << data.size() << '\t'
+                       << Milliseconds(templateReady - start).count() << '\t'
+                       << Milliseconds(generated - templateReady).count() << '\t'
+                       << Milliseconds(serialized - generated).count() << '\n';
+                output.write(data.data(), static_cast<std::streamsize>(data.size()));
+                output.flush();
+            } catch (const std::exception& e) {
+                writeError(id, e.what());
+            }
+        }
+    };
+
+    // Closes queue and joins started workers when leaving scope, including exception from
+    // starting a thread, so workers never wait for requests that will not come
+    struct WorkersGuard
+    {
+        RequestQueue& queue;
+        std::vector<std::thread> threads;
+
+        ~WorkersGuard()
+        {
+            queue.close();
+
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+    };
+
+    WorkersGuard workers{queue, {}};
+    workers.threads.reserve(threadsTotal);
+
+    for (std::size_t i = 0; i < threadsTotal; ++i) {
+        workers.threads.emplace_back(worker);
+    }
+
+    std::string line;
+    while (std::getline(input, line)) {
+        // Tolerate requests with Windows line endings
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        if (!line.empty()) {
+            queue.push(std::move(line));
+        }
+    }
+
+    // Guard lets workers finish remaining requests
+}
+
+} // namespace rsg
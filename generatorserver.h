@@ -0,0 +1,69 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "enums.h"
+#include "randomgenerator.h"
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace rsg {
+
+// Reads comma separated list of races, for example: Human,Dwarf,Random
+std::vector<RaceType> readRaces(const std::string& list);
+
+struct ServerOptions
+{
+    // Number of worker threads, 0 means use all hardware threads
+    std::size_t threads{};
+    // Maximum number of requests waiting for a worker, reading stops while queue is full
+    std::size_t queueSize{16};
+    // Maximum number of bytes template can allocate evaluating contents, 0 means no limit
+    std::size_t luaMemoryLimit{};
+    // Maximum number of templates whose Lua states are kept, least recently used are dropped
+    std::size_t templatePools{8};
+    RandomEngine randomEngine{RandomEngine::MersenneTwister};
+    // Reuse Lua states between requests instead of closing them with their arenas.
+    // Only for templates that do not change library tables, see LuaStatePool
+    bool reuseStates{};
+};
+
+// Serves scenario generation requests until input ends.
+// Each request is generated single threaded when there are several workers.
+// GameInfo and generator settings must be set up beforehand, they are shared between workers.
+// Workers share pools of Lua states for templates, each request executes template anew
+// in a new state, unless ServerOptions::reuseStates is set.
+// Pools are kept for up to ServerOptions::templatePools recently used templates.
+//
+// Request is a single line of tab separated fields:
+// id, template file, scenario size, races, seed and optional custom parameter values.
+// Races are comma separated, missing ones are random. Parameter values are comma separated.
+//
+// Responses are written in order of completion. Successful response is a line
+// "id\tok\tbytes\ttemplate_ms\tgenerate_ms\tserialize_ms" followed by 'bytes' of .sg file.
+// template_ms is the time to check out a Lua state and read template contents,
+// it includes executing the template when its pool has no idle state.
+// Failed one is a line "id\terror\tdescription".
+// Template print() output goes to stderr so it does not mix with responses.
+void runGeneratorServer(std::istream& input, std::ostream& output, const ServerOptions& options);
+
+} // namespace rsg
@@ -17,29 +17,259 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "batchgenerator.h"
+#include "generatorserver.h"
 #include "mapgenerator.h"
 #include "maptemplate.h"
 #include "maptemplatereader.h"
+#include "profiler.h"
 #include "standalonegameinfo.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <sol/sol.hpp>
 #include <stdexcept>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
 // debug
 #include "image.h"
 
+// Returns folder for parsed game info or empty path if caching is not enabled.
+// Caching is enabled by D2RSG_GAMEINFO_CACHE environment variable with a folder owned by user
+static std::filesystem::path getGameInfoCacheFolder()
+{
+    const char* folder{std::getenv("D2RSG_GAMEINFO_CACHE")};
+    if (!folder) {
+        return {};
+    }
+
+    return folder;
+}
+
+// Returns folder for compiled templates or empty path if caching is not enabled.
+// Caching is enabled by D2RSG_TEMPLATE_CACHE environment variable with a folder owned by user
+static std::filesystem::path getTemplateCacheFolder()
+{
+    const char* folder{std::getenv("D2RSG_TEMPLATE_CACHE")};
+    if (!folder) {
+        return {};
+    }
+
+    return folder;
+}
+
+// Removes flag from arguments, returns true if it was specified
+static bool takeFlag(int& argc, char* argv[], const char* flag)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], flag)) {
+            std::copy(argv + i + 1, argv + argc, argv + i);
+            --argc;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Removes option with its value from arguments, returns nullptr if it was not specified
+static const char* takeOption(int& argc, char* argv[], const char* option)
+{
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (!std::strcmp(argv[i], option)) {
+            const char* value{argv[i + 1]};
+            std::copy(argv + i + 2, argv + argc, argv + i);
+            argc -= 2;
+            return value;
+        }
+    }
+
+    return nullptr;
+}
+
+// Enables stage profiler if trace file name is specified
+static void startProfiling(const char* traceFileName)
+{
+    if (traceFileName) {
+        rsg::Profiler::setEnabled(true);
+    }
+}
+
+// Saves recorded stages in Chrome trace format and prints their summary
+static void stopProfiling(const char* traceFileName)
+{
+    if (!traceFileName) {
+        return;
+    }
+
+    rsg::Profiler::setEnabled(false);
+
+    std::ofstream trace{traceFileName};
+    rsg::Profiler::writeChromeTrace(trace);
+    rsg::Profiler::writeSummary(std::cout);
+}
+
+// argv[1] - "--batch"
+// argv[2] - template file
+// argv[3] - path to game
+// argv[4] - folder where to save created maps
+// argv[5] - scenario size
+// argv[6] - comma separated list of races, for example: Human,Dwarf,Random
+// argv[7] - first seed
+// argv[8] - last seed
+// argv[9] - number of worker threads, optional
+// argv[10] - file where to save stage timings in Chrome trace format, optional
+// "--reuse-states" anywhere after argv[1] keeps Lua states between seeds, see BatchOptions
+static int generateBatch(int argc, char* argv[], rsg::RandomEngine engine)
+{
+    using namespace rsg;
+
+    const bool reuseStates{takeFlag(argc, argv, "--reuse-states")};
+
+    if (argc < 9) {
+        std::cerr << "Usage: --batch template game_folder output_folder size races first_seed "
+                     "last_seed [threads] [trace_file] [--reuse-states] [--engine name]\n";
+        return 1;
+    }
+
+    try {
+        const StandaloneGameInfo info(argv[3], getGameInfoCacheFolder());
+        setGameInfo(&info);
+
+        BatchOptions options;
+        options.templatePath = argv[2];
+        options.outputFolder = argv[4];
+        options.size = std::stoi(argv[5]);
+        options.races = readRaces(argv[6]);
+        options.firstSeed = static_cast<std::time_t>(std::stoll(argv[7]));
+        options.lastSeed = static_cast<std::time_t>(std::stoll(argv[8]));
+        if (argc > 9) {
+            options.threads = static_cast<std::size_t>(std::stoul(argv[9]));
+        }
+
+        options.reuseStates = reuseStates;
+        options.randomEngine = engine;
+
+        const char* traceFileName{argc > 10 ? argv[10] : nullptr};
+
+        startProfiling(traceFileName);
+        const auto result{rsg::generateBatch(options)};
+        stopProfiling(traceFileName);
+
+        for (const auto& [seed, error] : result.failures) {
+            std::cerr << "Seed " << seed << ": " << error << '\n';
+        }
+
+        std::cout << "Generated " << result.generated << " scenarios, failed "
+                  << result.failures.size() << '\n';
+
+        return result.failures.empty() ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Exception during batch generation: " << e.what() << '\n';
+    }
+
+    return 1;
+}
+
+// argv[1] - "--serve"
+// argv[2] - path to game
+// argv[3] - number of worker threads, optional
+// argv[4] - maximum number of queued requests, optional
+// argv[5] - maximum Lua memory in megabytes template can use per request, optional
+// "--reuse-states" anywhere after argv[1] keeps Lua states between requests, see ServerOptions
+// Requests are read from stdin, responses are written to stdout, see runGeneratorServer()
+static int serve(int argc, char* argv[], rsg::RandomEngine engine)
+{
+    using namespace rsg;
+
+    const bool reuseStates{takeFlag(argc, argv, "--reuse-states")};
+
+    if (argc < 3) {
+        std::cerr << "Usage: --serve game_folder [threads] [queue_size] [lua_memory_mb] "
+                     "[--reuse-states] [--engine name]\n";
+        return 1;
+    }
+
+#ifdef _WIN32
+    // Responses contain binary scenario files
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    try {
+        // Game data is loaded once for all requests
+        const StandaloneGameInfo info(argv[2], getGameInfoCacheFolder());
+        setGameInfo(&info);
+
+        ServerOptions options;
+        if (argc > 3) {
+            options.threads = static_cast<std::size_t>(std::stoul(argv[3]));
+        }
+
+        if (argc > 4) {
+            options.queueSize = static_cast<std::size_t>(std::stoul(argv[4]));
+        }
+
+        if (argc > 5) {
+            options.luaMemoryLimit = static_cast<std::size_t>(std::stoul(argv[5])) * 1024 * 1024;
+        }
+
+        options.reuseStates = reuseStates;
+        options.randomEngine = engine;
+
+        runGeneratorServer(std::cin, std::cout, options);
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in generator server: " << e.what() << '\n';
+    }
+
+    return 1;
+}
+
 // argv[1] - template file
 // argv[2] - path to game
 // argv[3] - path where save created map
+// argv[4] - file where to save stage timings in Chrome trace format, optional
+// or see generateBatch() and serve() for batch and server mode arguments.
+// "--engine name" anywhere after argv[0] chooses random engine in all modes:
+// mt19937 (default) or xoshiro. Other engine is written to scenario description
 int main(int argc, char* argv[])
 {
     using namespace rsg;
 
-    assert(argc == 4);
+    RandomEngine engine{RandomEngine::MersenneTwister};
+    if (const char* engineName{takeOption(argc, argv, "--engine")}) {
+        if (!findRandomEngine(engineName, engine)) {
+            std::cerr << "Unknown random engine '" << engineName << "', use mt19937 or xoshiro\n";
+            return 1;
+        }
+    }
+
+    if (!setTemplateCacheFolder(getTemplateCacheFolder())) {
+        std::cerr << "Could not use template cache folder, templates are not cached\n";
+    }
+
+    if (argc > 1 && !std::strcmp(argv[1], "--batch")) {
+        return generateBatch(argc, argv, engine);
+    }
+
+    if (argc > 1 && !std::strcmp(argv[1], "--serve")) {
+        return serve(argc, argv, engine);
+    }
+
+    assert(argc == 4 || argc == 5);
+
+    const char* traceFileName{argc == 5 ? argv[4] : nullptr};
 
     const std::filesystem::path gameFolder{argv[2]};
 
     try {
-        const StandaloneGameInfo info(gameFolder);
+        const StandaloneGameInfo info(gameFolder, getGameInfoCacheFolder());
         setGameInfo(&info);
 
 #if 1
@@ -48,8 +278,6 @@ int main(int argc, char* argv[])
         std::time_t mapSeed = std::time_t(1673113695);
 #endif
 
-        const std::string seedString{std::to_string(mapSeed)};
-
         const std::filesystem::path templateFilePath{argv[1]};
 
         sol::state lua;
@@ -65,31 +293,18 @@ int main(int argc, char* argv[])
         settings.races.insert(settings.races.end(), settings.maxPlayers, RaceType::Random);
         settings.size = 72;
 
-        MapGenOptions options;
-        options.mapTemplate = &mapTemplate;
-
-        // MapTemplateSettings name and description are used for ingame (or standalone tool) UI
-        // only.
-        options.name = std::string{"Random scenario "} + seedString;
-        options.description = std::string{"Random scenario based on template '"} + settings.name
-                              + std::string{"'. Seed: "} + seedString
-                              + ". Starting gold: " + std::to_string(settings.startingGold)
-                              + ". Roads: " + std::to_string(settings.roads)
-                              + "%. Forest: " + std::to_string(settings.forest) + "%.";
-        options.size = settings.size;
-
+        MapGenOptions options{createMapGenOptions(mapTemplate, mapSeed, engine)};
         MapGenerator generator{options, mapSeed};
 
-        settings.replaceRandomRaces(generator.randomGenerator);
-
-        // Generate template contents
-        readTemplateContents(mapTemplate, lua);
-
-        auto map{generator.generate()};
+        startProfiling(traceFileName);
+        auto map{generateScenario(generator, mapTemplate, lua)};
 
         const std::filesystem::path scenarioFilePath{argv[3]};
 
         map->serialize(scenarioFilePath);
+        stopProfiling(traceFileName);
+
+        std::cout << "Zone placement made " << generator.placementIterations << " iterations\n";
 
         {
             const auto width{generator.mapGenOptions.size};
@@ -0,0 +1,133 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mappedfile.h"
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace rsg {
+
+MappedFile::MappedFile(const std::filesystem::path& filePath)
+{
+#ifdef _WIN32
+    HANDLE file{::CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr)};
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (!::GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        // Empty files can not be mapped
+        ::CloseHandle(file);
+        return;
+    }
+
+    HANDLE mapping{::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr)};
+    ::CloseHandle(file);
+
+    if (!mapping) {
+        return;
+    }
+
+    // View keeps mapping alive, handle is not needed anymore
+    void* address{::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)};
+    ::CloseHandle(mapping);
+
+    if (!address) {
+        return;
+    }
+
+    view = static_cast<const std::uint8_t*>(address);
+    length = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+    const int file{::open(filePath.c_str(), O_RDONLY)};
+    if (file == -1) {
+        return;
+    }
+
+    struct stat status{};
+    if (::fstat(file, &status) == -1 || status.st_size == 0) {
+        // Empty files can not be mapped
+        ::close(file);
+        return;
+    }
+
+    const auto fileSize{static_cast<std::size_t>(status.st_size)};
+    void* address{::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, file, 0)};
+    // Mapping stays valid after descriptor is closed
+    ::close(file);
+
+    if (address == MAP_FAILED) {
+        return;
+    }
+
+    view = static_cast<const std::uint8_t*>(address);
+    length = fileSize;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : view{std::exchange(other.view, nullptr)}
+    , length{std::exchange(other.length, 0)}
+{ }
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other) {
+        unmap();
+        view = std::exchange(other.view, nullptr);
+        length = std::exchange(other.length, 0);
+    }
+
+    return *this;
+}
+
+void MappedFile::unmap()
+{
+    if (!view) {
+        return;
+    }
+
+#ifdef _WIN32
+    ::UnmapViewOfFile(view);
+#else
+    ::munmap(const_cast<std::uint8_t*>(view), length);
+#endif
+
+    view = nullptr;
+    length = 0;
+}
+
+} // namespace rsg
@@ -0,0 +1,66 @@
+/*
+ * This file is part of the random scenario generator for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2RSG)
+ * Copyright (C) 2023 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace rsg {
+
+// Read-only view of a whole file mapped into memory.
+// File contents are loaded by the OS on access and are shared with its file cache
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    // Maps specified file, check operator bool for success
+    explicit MappedFile(const std::filesystem::path& filePath);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    operator bool() const
+    {
+        return view != nullptr;
+    }
+
+    const std::uint8_t* data() const
+    {
+        return view;
+    }
+
+    std::size_t size() const
+    {
+        return length;
+    }
+
+private:
+    void unmap();
+
+    const std::uint8_t* view{};
+    std::size_t length{};
+};
+
+} // namespace rsg
@@ -20,15 +20,23 @@
 #include "standalonegameinfo.h"
 #include "currency.h"
 #include "dbf.h"
+#include "gameinfocache.h"
 #include "generatorsettings.h"
+#include "parallel.h"
+#include "privatefiles.h"
 #include "standaloneiteminfo.h"
 #include "standalonelandmarkinfo.h"
 #include "standaloneraceinfo.h"
 #include "standalonespellinfo.h"
 #include "standaloneunitinfo.h"
 #include "textconvert.h"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <exception>
+#include <functional>
 #include <iostream>
+#include <thread>
 
 namespace rsg {
 
@@ -40,10 +48,59 @@ static bool isVanillaReachId(int reachId)
            || reachId == (int)ReachType::Adjacent;
 }
 
-static bool readId(const Dbf::Record& record, const char* column, CMidgardID& id)
+// Returns true if raw item category (from GItem.dbf) is one of known item types
+static bool isKnownItemType(int category)
+{
+    return category >= (int)ItemType::Armor && category <= (int)ItemType::Special;
+}
+
+static bool isKnownSpellType(int type)
+{
+    return type >= (int)SpellType::Attack && type <= (int)SpellType::GiveWards;
+}
+
+static bool isKnownLandmarkType(int type)
+{
+    return type >= (int)LandmarkType::Misc && type <= (int)LandmarkType::Terrain;
+}
+
+// Random race is never read from game files
+static bool isKnownRaceType(int type)
+{
+    return type >= (int)RaceType::Human && type <= (int)RaceType::Elf;
+}
+
+static bool isKnownSubRaceType(int type)
+{
+    return type >= (int)SubRaceType::Custom && type <= (int)SubRaceType::Sub34;
+}
+
+// Reports field that is missing in database or has unexpected type
+template <typename T>
+static bool checkField(const Dbf& db, const Dbf::Field<T>& field)
+{
+    if (!field) {
+        std::cerr << "Missing or wrong '" << field.name() << "' column in "
+                  << db.path().filename().string() << '\n';
+        return false;
+    }
+
+    return true;
+}
+
+// Checks that all fields required to read database are bound
+template <typename... T>
+static bool checkFields(const Dbf& db, const Dbf::Field<T>&... fields)
+{
+    return (checkField(db, fields) && ...);
+}
+
+static bool readId(const Dbf::Record& record,
+                   const Dbf::Field<std::string_view>& field,
+                   CMidgardID& id)
 {
     std::string_view idString{};
-    if (!record.value(idString, column)) {
+    if (!record.value(idString, field)) {
         return false;
     }
 
@@ -56,11 +113,11 @@ static bool readId(const Dbf::Record& record, const char* column, CMidgardID& id
     return true;
 }
 
-static bool readTexts(TextsInfo& texts,
+static bool readTexts(TextTable& table,
                       const std::filesystem::path& folderPath,
                       const char* dbFileName)
 {
-    texts.clear();
+    TextsInfo texts;
 
     Dbf db{folderPath / dbFileName};
     if (!db) {
@@ -68,13 +125,13 @@ static bool readTexts(TextsInfo& texts,
         return false;
     }
 
-    const Dbf::Column* textColumn{db.column("TEXT")};
-    if (!textColumn) {
-        std::cerr << "Missing 'TEXT' column in " << dbFileName << '\n';
+    const auto textIdField{db.field<std::string_view>("TXT_ID")};
+    const auto textField{db.field<std::string_view>("TEXT")};
+    if (!checkFields(db, textIdField, textField)) {
         return false;
     }
 
-    const std::uint8_t textLength{textColumn->length};
+    const std::uint8_t textLength{textField.get()->length};
 
     for (const auto& record : db) {
         if (record.deleted()) {
@@ -82,18 +139,19 @@ static bool readTexts(TextsInfo& texts,
         }
 
         CMidgardID textId;
-        if (!readId(record, "TXT_ID", textId)) {
+        if (!readId(record, textIdField, textId)) {
             continue;
         }
 
         std::string_view textView{};
-        if (!record.value(textView, "TEXT")) {
+        if (!record.value(textView, textField)) {
             continue;
         }
 
         texts[textId] = translate(textView, textLength);
     }
 
+    table.assign(texts);
     return true;
 }
 
@@ -109,8 +167,20 @@ static bool readSiteText(SiteTexts& texts,
         return false;
     }
 
-    const auto nameLength = db.column("NAME")->length;
-    const auto descriptionLength = db.column("DESC")->length;
+    const auto nameField{db.field<std::string_view>("NAME")};
+    if (!checkField(db, nameField)) {
+        return false;
+    }
+
+    Dbf::Field<std::string_view> descriptionField;
+    if (readDescriptions) {
+        descriptionField = db.field<std::string_view>("DESC");
+        if (!checkField(db, descriptionField)) {
+            return false;
+        }
+    }
+
+    const auto nameLength = nameField.get()->length;
 
     for (const auto& record : db) {
         if (record.deleted()) {
@@ -118,7 +188,7 @@ static bool readSiteText(SiteTexts& texts,
         }
 
         std::string_view nameView{};
-        if (!record.value(nameView, "NAME")) {
+        if (!record.value(nameView, nameField)) {
             continue;
         }
 
@@ -127,8 +197,8 @@ static bool readSiteText(SiteTexts& texts,
 
         if (readDescriptions) {
             std::string_view descriptionView{};
-            if (record.value(descriptionView, "DESC")) {
-                text.description = translate(descriptionView, descriptionLength);
+            if (record.value(descriptionView, descriptionField)) {
+                text.description = translate(descriptionView, descriptionField.get()->length);
             }
         }
 
@@ -138,11 +208,43 @@ static bool readSiteText(SiteTexts& texts,
     return true;
 }
 
-StandaloneGameInfo::StandaloneGameInfo(const std::filesystem::path& gameFolderPath)
+StandaloneGameInfo::StandaloneGameInfo(const std::filesystem::path& gameFolderPath,
+                                       const std::filesystem::path& cacheFolder)
 {
+    std::filesystem::path cacheFilePath;
+    std::uint64_t cacheKey{};
+
+    if (!cacheFolder.empty()) {
+        // Cache contents are trusted, so nobody else must be able to write them
+        if (createPrivateFolder(cacheFolder)) {
+            cacheFilePath = getGameInfoCachePath(cacheFolder, gameFolderPath);
+        } else {
+            std::cerr << "Could not use game info cache folder " << cacheFolder.string() << '\n';
+        }
+    }
+
+    if (!cacheFilePath.empty()) {
+        cacheKey = computeGameInfoCacheKey(gameFolderPath);
+
+        if (readCache(cacheFilePath, cacheKey)) {
+            return;
+        }
+    }
+
     if (!readGameInfo(gameFolderPath)) {
         throw std::runtime_error("Could not read game info");
     }
+
+    if (cacheFilePath.empty()) {
+        return;
+    }
+
+    try {
+        writeCache(cacheFilePath, cacheKey);
+    } catch (const std::exception& e) {
+        // Not critical, game info will be read from game files next time
+        std::cerr << e.what() << '\n';
+    }
 }
 
 const UnitsInfo& StandaloneGameInfo::getUnits() const
@@ -307,10 +409,10 @@ const SiteTexts& StandaloneGameInfo::getTrainerTexts() const
     return trainerTexts;
 }
 
-const char* StandaloneGameInfo::getText(const TextsInfo& texts, const CMidgardID& textId) const
+const char* StandaloneGameInfo::getText(const TextTable& texts, const CMidgardID& textId) const
 {
-    const auto it{texts.find(textId)};
-    if (it == texts.end()) {
+    const char* text{texts.find(textId)};
+    if (!text) {
         // Return a string that is easy to spot in the game/editor.
         // This should help tracking potential problem
         return "NOT FOUND";
@@ -318,7 +420,7 @@ const char* StandaloneGameInfo::getText(const TextsInfo& texts, const CMidgardID
 
     // This is fine because we don't change texts after loading
     // and GameInfo lives longer than scenario generator
-    return it->second.c_str();
+    return text;
 }
 
 bool StandaloneGameInfo::readUnitsInfo(const std::filesystem::path& globalsFolderPath)
@@ -347,13 +449,20 @@ bool StandaloneGameInfo::readUnitsInfo(const std::filesystem::path& globalsFolde
         // Don't bother reading even vanilla ones if there are no custom reaches
         customReaches = reachDb.column("MELEE") != nullptr;
         if (customReaches) {
+            const auto idField{reachDb.field<int>("ID")};
+            const auto meleeField{reachDb.field<bool>("MELEE")};
+            const auto maxTargetsField{reachDb.field<int>("MAX_TARGTS")};
+            if (!checkFields(reachDb, idField, meleeField, maxTargetsField)) {
+                return false;
+            }
+
             for (const auto& record : reachDb) {
                 if (record.deleted()) {
                     continue;
                 }
 
                 int rawId{};
-                if (!record.value(rawId, "ID")) {
+                if (!record.value(rawId, idField)) {
                     continue;
                 }
 
@@ -364,7 +473,7 @@ bool StandaloneGameInfo::readUnitsInfo(const std::filesystem::path& globalsFolde
                     // depending on 'melee' hint and max targets count.
                     // We don't care about their actual logic
                     bool melee{false};
-                    if (!record.value(melee, "MELEE")) {
+                    if (!record.value(melee, meleeField)) {
                         continue;
                     }
 
@@ -374,7 +483,7 @@ bool StandaloneGameInfo::readUnitsInfo(const std::filesystem::path& globalsFolde
                         // Non-melee custom reaches with 6 max targets becomes 'All',
                         // others are 'Any'
                         int maxTargets{};
-                        if (!record.value(maxTargets, "MAX_TARGTS")) {
+                        if (!record.value(maxTargets, maxTargetsField)) {
                             continue;
                         }
 
@@ -396,13 +505,20 @@ bool StandaloneGameInfo::readUnitsInfo(const std::filesystem::path& globalsFolde
             return false;
         }
 
+        const auto attackIdField{attacksDb.field<std::string_view>("ATT_ID")};
+        const auto reachField{attacksDb.field<int>("REACH")};
+        const auto classField{attacksDb.field<int>("CLASS")};
+        if (!checkFields(attacksDb, attackIdField, reachField, classField)) {
+            return false;
+        }
+
         for (const auto& record : attacksDb) {
             if (record.deleted()) {
                 continue;
             }
 
             std::string_view idString{};
-            if (!record.value(idString, "ATT_ID")) {
+            if (!record.value(idString, attackIdField)) {
                 continue;
             }
 
@@ -412,12 +528,12 @@ bool StandaloneGameInfo::readUnitsInfo(const std::filesystem::path& globalsFolde
             }
 
             int reach{};
-            if (!record.value(reach, "REACH")) {
+            if (!record.value(reach, reachField)) {
                 continue;
             }
 
             int type{};
-            if (!record.value(type, "CLASS")) {
+            if (!record.value(type, classField)) {
                 continue;
             }
 
@@ -443,13 +559,34 @@ bool StandaloneGameInfo::readUnitsInfo(const std::filesystem::path& globalsFolde
         return false;
     }
 
+    const auto waterOnlyField{unitsDb.field<bool>("WATER_ONLY")};
+    const auto unitIdField{unitsDb.field<std::string_view>("UNIT_ID")};
+    const auto unitCategoryField{unitsDb.field<int>("UNIT_CAT")};
+    const auto levelField{unitsDb.field<int>("LEVEL")};
+    const auto raceIdField{unitsDb.field<std::string_view>("RACE_ID")};
+    const auto sizeSmallField{unitsDb.field<bool>("SIZE_SMALL")};
+    const auto maleField{unitsDb.field<bool>("SEX_M")};
+    const auto subraceField{unitsDb.field<int>("SUBRACE")};
+    const auto nameIdField{unitsDb.field<std::string_view>("NAME_TXT")};
+    const auto attackIdField{unitsDb.field<std::string_view>("ATTACK_ID")};
+    const auto hitPointsField{unitsDb.field<int>("HIT_POINT")};
+    const auto moveField{unitsDb.field<int>("MOVE")};
+    const auto leadershipField{unitsDb.field<int>("LEADERSHIP")};
+    const auto xpKilledField{unitsDb.field<int>("XP_KILLED")};
+
+    if (!checkFields(unitsDb, waterOnlyField, unitIdField, unitCategoryField, levelField,
+                     raceIdField, sizeSmallField, maleField, subraceField, nameIdField,
+                     attackIdField, hitPointsField, moveField, leadershipField, xpKilledField)) {
+        return false;
+    }
+
     for (const auto& record : unitsDb) {
         if (record.deleted()) {
             continue;
         }
 
         bool waterOnly{};
-        if (!record.value(waterOnly, "WATER_ONLY")) {
+        if (!record.value(waterOnly, waterOnlyField)) {
             continue;
         }
 
@@ -459,7 +596,7 @@ bool StandaloneGameInfo::readUnitsInfo(const std::filesystem::path& globalsFolde
         }
 
         std::string_view idString{};
-        if (!record.value(idString, "UNIT_ID")) {
+        if (!record.value(idString, unitIdField)) {
             continue;
         }
 
@@ -469,19 +606,19 @@ bool StandaloneGameInfo::readUnitsInfo(const std::filesystem::path& globalsFolde
         }
 
         int type{};
-        if (!record.value(type, "UNIT_CAT")) {
+        if (!record.value(type, unitCategoryField)) {
             continue;
         }
 
         const auto unitType{static_cast<UnitType>(type)};
 
         int level{};
-        if (!record.value(level, "LEVEL")) {
+        if (!record.value(level, levelField)) {
             continue;
         }
 
         std::string_view raceIdString{};
-        if (!record.value(raceIdString, "RACE_ID")) {
+        if (!record.value(raceIdString, raceIdField)) {
             continue;
         }
 
@@ -491,22 +628,22 @@ bool StandaloneGameInfo::readUnitsInfo(const std::filesystem::path& globalsFolde
         }
 
         bool smallUnit{};
-        if (!record.value(smallUnit, "SIZE_SMALL")) {
+        if (!record.value(smallUnit, sizeSmallField)) {
             continue;
         }
 
         bool male{};
-        if (!record.value(male, "SEX_M")) {
+        if (!record.value(male, maleField)) {
             continue;
         }
 
         int subrace{};
-        if (!record.value(subrace, "SUBRACE")) {
+        if (!record.value(subrace, subraceField)) {
             continue;
         }
 
         std::string_view nameIdString{};
-        if (!record.value(nameIdString, "NAME_TXT")) {
+        if (!record.value(nameIdString, nameIdField)) {
             continue;
         }
 
@@ -517,7 +654,7 @@ bool StandaloneGameInfo::readUnitsInfo(const std::filesystem::path& globalsFolde
 
         // We only interested in primary attack
         std::string_view attackString{};
-        if (!record.value(attackString, "ATTACK_ID")) {
+        if (!record.value(attackString, attackIdField)) {
             continue;
         }
 
@@ -534,24 +671,24 @@ bool StandaloneGameInfo::readUnitsInfo(const std::filesystem::path& globalsFolde
         }
 
         int hp{};
-        if (!record.value(hp, "HIT_POINT")) {
+        if (!record.value(hp, hitPointsField)) {
             continue;
         }
 
         int move{};
         int leadership{};
         if (unitType == UnitType::Leader) {
-            if (!record.value(move, "MOVE")) {
+            if (!record.value(move, moveField)) {
                 continue;
             }
 
-            if (!record.value(leadership, "LEADERSHIP")) {
+            if (!record.value(leadership, leadershipField)) {
                 continue;
             }
         }
 
         int value{};
-        if (!record.value(value, "XP_KILLED")) {
+        if (!record.value(value, xpKilledField)) {
             continue;
         }
 
@@ -561,38 +698,45 @@ bool StandaloneGameInfo::readUnitsInfo(const std::filesystem::path& globalsFolde
 
         auto& pair{it->second};
 
-        auto info{std::make_unique<StandaloneUnitInfo>(unitId, raceId, nameId, level, value,
-                                                       unitType, static_cast<SubRaceType>(subrace),
-                                                       pair.first, pair.second, hp, move,
-                                                       leadership, !smallUnit, male)};
+        addUnit(std::make_unique<StandaloneUnitInfo>(unitId, raceId, nameId, level, value,
+                                                     unitType, static_cast<SubRaceType>(subrace),
+                                                     pair.first, pair.second, hp, move,
+                                                     leadership, !smallUnit, male));
+    }
 
-        if (unitType == UnitType::Leader) {
-            leaders.push_back(info.get());
+    return true;
+}
 
-            if (value < minLeaderValue) {
-                minLeaderValue = value;
-            }
+void StandaloneGameInfo::addUnit(std::unique_ptr<StandaloneUnitInfo>&& info)
+{
+    const auto value{info->getValue()};
+    const auto unitType{info->getUnitType()};
 
-            if (value > maxLeaderValue) {
-                maxLeaderValue = value;
-            }
+    if (unitType == UnitType::Leader) {
+        leaders.push_back(info.get());
 
-        } else if (unitType == UnitType::Soldier) {
-            soldiers.push_back(info.get());
+        if (value < minLeaderValue) {
+            minLeaderValue = value;
+        }
 
-            if (value < minSoldierValue) {
-                minSoldierValue = value;
-            }
+        if (value > maxLeaderValue) {
+            maxLeaderValue = value;
+        }
 
-            if (value > maxSoldierValue) {
-                maxSoldierValue = value;
-            }
+    } else if (unitType == UnitType::Soldier) {
+        soldiers.push_back(info.get());
+
+        if (value < minSoldierValue) {
+            minSoldierValue = value;
         }
 
-        unitsInfo[unitId] = std::move(info);
+        if (value > maxSoldierValue) {
+            maxSoldierValue = value;
+        }
     }
 
-    return true;
+    const auto unitId{info->getUnitId()};
+    unitsInfo[unitId] = std::move(info);
 }
 
 bool StandaloneGameInfo::readItemsInfo(const std::filesystem::path& globalsFolderPath)
@@ -607,23 +751,35 @@ bool StandaloneGameInfo::readItemsInfo(const std::filesystem::path& globalsFolde
         return false;
     }
 
+    const auto categoryField{itemsDb.field<int>("ITEM_CAT")};
+    const auto itemIdField{itemsDb.field<std::string_view>("ITEM_ID")};
+    const auto valueField{itemsDb.field<std::string_view>("VALUE")};
+    if (!checkFields(itemsDb, categoryField, itemIdField, valueField)) {
+        return false;
+    }
+
     for (const auto& record : itemsDb) {
         if (record.deleted()) {
             continue;
         }
 
         int type{};
-        if (!record.value(type, "ITEM_CAT")) {
+        if (!record.value(type, categoryField)) {
+            continue;
+        }
+
+        // Categories added by mods are not supported by generator
+        if (!isKnownItemType(type)) {
             continue;
         }
 
         CMidgardID itemId;
-        if (!readId(record, "ITEM_ID", itemId)) {
+        if (!readId(record, itemIdField, itemId)) {
             continue;
         }
 
         std::string_view valueString{};
-        if (!record.value(valueString, "VALUE")) {
+        if (!record.value(valueString, valueField)) {
             continue;
         }
 
@@ -643,16 +799,21 @@ bool StandaloneGameInfo::readItemsInfo(const std::filesystem::path& globalsFolde
             value *= 5;
         }
 
-        auto info{std::make_unique<StandaloneItemInfo>(itemId, value, itemType)};
-
-        allItems.push_back(info.get());
-        itemsByType[itemType].push_back(info.get());
-        itemsInfo[itemId] = std::move(info);
+        addItem(std::make_unique<StandaloneItemInfo>(itemId, value, itemType));
     }
 
     return true;
 }
 
+void StandaloneGameInfo::addItem(std::unique_ptr<StandaloneItemInfo>&& info)
+{
+    allItems.push_back(info.get());
+    itemsByType[info->getItemType()].push_back(info.get());
+
+    const auto itemId{info->getItemId()};
+    itemsInfo[itemId] = std::move(info);
+}
+
 bool StandaloneGameInfo::readSpellsInfo(const std::filesystem::path& globalsFolderPath)
 {
     spellsInfo.clear();
@@ -665,28 +826,36 @@ bool StandaloneGameInfo::readSpellsInfo(const std::filesystem::path& globalsFold
         return false;
     }
 
+    const auto spellIdField{spellsDb.field<std::string_view>("SPELL_ID")};
+    const auto categoryField{spellsDb.field<int>("CATEGORY")};
+    const auto levelField{spellsDb.field<int>("LEVEL")};
+    const auto buyCostField{spellsDb.field<std::string_view>("BUY_C")};
+    if (!checkFields(spellsDb, spellIdField, categoryField, levelField, buyCostField)) {
+        return false;
+    }
+
     for (const auto& record : spellsDb) {
         if (record.deleted()) {
             continue;
         }
 
         CMidgardID spellId;
-        if (!readId(record, "SPELL_ID", spellId)) {
+        if (!readId(record, spellIdField, spellId)) {
             continue;
         }
 
         int type{};
-        if (!record.value(type, "CATEGORY")) {
+        if (!record.value(type, categoryField)) {
             continue;
         }
 
         int level{};
-        if (!record.value(level, "LEVEL")) {
+        if (!record.value(level, levelField)) {
             continue;
         }
 
         std::string_view costString{};
-        if (!record.value(costString, "BUY_C")) {
+        if (!record.value(costString, buyCostField)) {
             continue;
         }
 
@@ -701,19 +870,25 @@ bool StandaloneGameInfo::readSpellsInfo(const std::filesystem::path& globalsFold
 
         auto spellType{static_cast<SpellType>(type)};
 
-        auto info{std::make_unique<StandaloneSpellInfo>(spellId, value, level, spellType)};
-
-        allSpells.push_back(info.get());
-        spellsByType[spellType].push_back(info.get());
-        spellsInfo[spellId] = std::move(info);
+        addSpell(std::make_unique<StandaloneSpellInfo>(spellId, value, level, spellType));
     }
 
     return true;
 }
 
+void StandaloneGameInfo::addSpell(std::unique_ptr<StandaloneSpellInfo>&& info)
+{
+    allSpells.push_back(info.get());
+    spellsByType[info->getSpellType()].push_back(info.get());
+
+    const auto spellId{info->getSpellId()};
+    spellsInfo[spellId] = std::move(info);
+}
+
 bool StandaloneGameInfo::readLandmarksInfo(const std::filesystem::path& globalsFolderPath)
 {
     landmarksInfo.clear();
+    allLandmarks.clear();
     landmarksByType.clear();
     landmarksByRace.clear();
     mountainLandmarks.clear();
@@ -724,73 +899,89 @@ bool StandaloneGameInfo::readLandmarksInfo(const std::filesystem::path& globalsF
         return false;
     }
 
+    const auto landmarkIdField{landmarksDb.field<std::string_view>("LMARK_ID")};
+    const auto sizeXField{landmarksDb.field<int>("CX")};
+    const auto sizeYField{landmarksDb.field<int>("CY")};
+    const auto mountainField{landmarksDb.field<bool>("MOUNTAIN")};
+    const auto categoryField{landmarksDb.field<int>("CATEGORY")};
+    if (!checkFields(landmarksDb, landmarkIdField, sizeXField, sizeYField, mountainField,
+                     categoryField)) {
+        return false;
+    }
+
     for (const auto& record : landmarksDb) {
         if (record.deleted()) {
             continue;
         }
 
         CMidgardID landmarkId;
-        if (!readId(record, "LMARK_ID", landmarkId)) {
+        if (!readId(record, landmarkIdField, landmarkId)) {
             continue;
         }
 
         int x{};
-        if (!record.value(x, "CX")) {
+        if (!record.value(x, sizeXField)) {
             continue;
         }
 
         int y{};
-        if (!record.value(y, "CY")) {
+        if (!record.value(y, sizeYField)) {
             continue;
         }
 
         bool mountain{};
-        if (!record.value(mountain, "MOUNTAIN")) {
+        if (!record.value(mountain, mountainField)) {
             continue;
         }
 
         int type{};
-        if (!record.value(type, "CATEGORY")) {
+        if (!record.value(type, categoryField)) {
             continue;
         }
 
         auto landmarkType{static_cast<LandmarkType>(type)};
-        auto info{std::make_unique<StandaloneLandmarkInfo>(landmarkId, Position{x, y}, landmarkType,
-                                                           mountain)};
+        addLandmark(std::make_unique<StandaloneLandmarkInfo>(landmarkId, Position{x, y},
+                                                             landmarkType, mountain));
+    }
 
-        if (isEmpireLandmark(landmarkId)) {
-            landmarksByRace[RaceType::Human].push_back(info.get());
-        }
+    return true;
+}
 
-        if (isClansLandmark(landmarkId)) {
-            landmarksByRace[RaceType::Dwarf].push_back(info.get());
-        }
+void StandaloneGameInfo::addLandmark(std::unique_ptr<StandaloneLandmarkInfo>&& info)
+{
+    const auto landmarkId{info->getLandmarkId()};
 
-        if (isUndeadLandmark(landmarkId)) {
-            landmarksByRace[RaceType::Undead].push_back(info.get());
-        }
+    if (isEmpireLandmark(landmarkId)) {
+        landmarksByRace[RaceType::Human].push_back(info.get());
+    }
 
-        if (isLegionsLandmark(landmarkId)) {
-            landmarksByRace[RaceType::Heretic].push_back(info.get());
-        }
+    if (isClansLandmark(landmarkId)) {
+        landmarksByRace[RaceType::Dwarf].push_back(info.get());
+    }
 
-        if (isElvesLandmark(landmarkId)) {
-            landmarksByRace[RaceType::Elf].push_back(info.get());
-        }
+    if (isUndeadLandmark(landmarkId)) {
+        landmarksByRace[RaceType::Undead].push_back(info.get());
+    }
 
-        if (isNeutralLandmark(landmarkId)) {
-            landmarksByRace[RaceType::Neutral].push_back(info.get());
-        }
+    if (isLegionsLandmark(landmarkId)) {
+        landmarksByRace[RaceType::Heretic].push_back(info.get());
+    }
 
-        if (isMountainLandmark(landmarkId)) {
-            mountainLandmarks.push_back(info.get());
-        }
+    if (isElvesLandmark(landmarkId)) {
+        landmarksByRace[RaceType::Elf].push_back(info.get());
+    }
 
-        landmarksByType[landmarkType].push_back(info.get());
-        landmarksInfo[landmarkId] = std::move(info);
+    if (isNeutralLandmark(landmarkId)) {
+        landmarksByRace[RaceType::Neutral].push_back(info.get());
     }
 
-    return true;
+    if (isMountainLandmark(landmarkId)) {
+        mountainLandmarks.push_back(info.get());
+    }
+
+    allLandmarks.push_back(info.get());
+    landmarksByType[info->getLandmarkType()].push_back(info.get());
+    landmarksInfo[landmarkId] = std::move(info);
 }
 
 bool StandaloneGameInfo::readRacesInfo(const std::filesystem::path& globalsFolderPath)
@@ -805,23 +996,30 @@ bool StandaloneGameInfo::readRacesInfo(const std::filesystem::path& globalsFolde
         return false;
     }
 
+    const auto nameRaceIdField{namesDb.field<std::string_view>("RACE_ID")};
+    const auto maleField{namesDb.field<bool>("SEX_M")};
+    const auto textField{namesDb.field<std::string_view>("TEXT")};
+    if (!checkFields(namesDb, nameRaceIdField, maleField, textField)) {
+        return false;
+    }
+
     for (const auto& record : namesDb) {
         if (record.deleted()) {
             continue;
         }
 
         CMidgardID raceId;
-        if (!readId(record, "RACE_ID", raceId)) {
+        if (!readId(record, nameRaceIdField, raceId)) {
             continue;
         }
 
         bool male{};
-        if (!record.value(male, "SEX_M")) {
+        if (!record.value(male, maleField)) {
             continue;
         }
 
         std::string_view nameView{};
-        if (!record.value(nameView, "TEXT")) {
+        if (!record.value(nameView, textField)) {
             continue;
         }
 
@@ -838,7 +1036,21 @@ bool StandaloneGameInfo::readRacesInfo(const std::filesystem::path& globalsFolde
         return false;
     }
 
-    char columnName[9] = {'L', 'E', 'A', 'D', 'E', 'R', '_', '1', 0};
+    const auto raceIdField{racesDb.field<std::string_view>("RACE_ID")};
+    const auto guardianField{racesDb.field<std::string_view>("GUARDIAN")};
+    const auto nobleField{racesDb.field<std::string_view>("NOBLE")};
+    const auto raceTypeField{racesDb.field<int>("RACE_TYPE")};
+    const Dbf::Field<std::string_view> leaderFields[] = {
+        racesDb.field<std::string_view>("LEADER_1"),
+        racesDb.field<std::string_view>("LEADER_2"),
+        racesDb.field<std::string_view>("LEADER_3"),
+        racesDb.field<std::string_view>("LEADER_4"),
+    };
+
+    if (!checkFields(racesDb, raceIdField, guardianField, nobleField, raceTypeField,
+                     leaderFields[0], leaderFields[1], leaderFields[2], leaderFields[3])) {
+        return false;
+    }
 
     for (const auto& record : racesDb) {
         if (record.deleted()) {
@@ -846,26 +1058,24 @@ bool StandaloneGameInfo::readRacesInfo(const std::filesystem::path& globalsFolde
         }
 
         CMidgardID raceId;
-        if (!readId(record, "RACE_ID", raceId)) {
+        if (!readId(record, raceIdField, raceId)) {
             continue;
         }
 
         CMidgardID guardId;
-        if (!readId(record, "GUARDIAN", guardId)) {
+        if (!readId(record, guardianField, guardId)) {
             continue;
         }
 
         CMidgardID nobleId;
-        if (!readId(record, "NOBLE", nobleId)) {
+        if (!readId(record, nobleField, nobleId)) {
             continue;
         }
 
         bool failed{};
-        std::vector<CMidgardID> leaderIds(4);
+        std::vector<CMidgardID> leaderIds(std::size(leaderFields));
         for (std::size_t i = 0; i < std::size(leaderIds); ++i) {
-            columnName[7] = '1' + static_cast<char>(i);
-
-            if (!readId(record, columnName, leaderIds[i])) {
+            if (!readId(record, leaderFields[i], leaderIds[i])) {
                 failed = true;
                 break;
             }
@@ -876,7 +1086,7 @@ bool StandaloneGameInfo::readRacesInfo(const std::filesystem::path& globalsFolde
         }
 
         int type;
-        if (!record.value(type, "RACE_TYPE")) {
+        if (!record.value(type, raceTypeField)) {
             continue;
         }
 
@@ -911,7 +1121,12 @@ bool StandaloneGameInfo::readCityNames(const std::filesystem::path& scenDataFold
         return false;
     }
 
-    const auto textLength = namesDb.column("NAME")->length;
+    const auto nameField{namesDb.field<std::string_view>("NAME")};
+    if (!checkField(namesDb, nameField)) {
+        return false;
+    }
+
+    const auto textLength = nameField.get()->length;
 
     for (const auto& record : namesDb) {
         if (record.deleted()) {
@@ -919,7 +1134,7 @@ bool StandaloneGameInfo::readCityNames(const std::filesystem::path& scenDataFold
         }
 
         std::string_view nameView{};
-        if (!record.value(nameView, "NAME")) {
+        if (!record.value(nameView, nameField)) {
             continue;
         }
 
@@ -938,17 +1153,330 @@ bool StandaloneGameInfo::readSiteTexts(const std::filesystem::path& scenDataFold
            && readSiteText(trainerTexts, scenDataFolderPath / "Trainame.dbf");
 }
 
+static void writeCachedUnit(CacheWriter& writer, const UnitInfo& unit)
+{
+    writer.write(unit.getUnitId());
+    writer.write(unit.getRaceId());
+    writer.write(unit.getNameId());
+    writer.write(unit.getLevel());
+    writer.write(unit.getValue());
+    writer.write(static_cast<int>(unit.getUnitType()));
+    writer.write(static_cast<int>(unit.getSubrace()));
+    writer.write(static_cast<int>(unit.getAttackReach()));
+    writer.write(static_cast<int>(unit.getAttackType()));
+    writer.write(unit.getHp());
+    writer.write(unit.getMove());
+    writer.write(unit.getLeadership());
+    writer.write(unit.isBig());
+    writer.write(unit.isMale());
+}
+
+// Reads enumeration value from cache, throws if it is not one of known values
+static int readCachedEnum(CacheReader& reader, bool (*isKnown)(int), const char* description)
+{
+    const auto value{reader.read<int>()};
+    if (!isKnown(value)) {
+        throw std::runtime_error(std::string("Game info cache has unknown ") + description);
+    }
+
+    return value;
+}
+
+static std::unique_ptr<StandaloneUnitInfo> readCachedUnit(CacheReader& reader)
+{
+    const auto unitId{reader.read<CMidgardID>()};
+    const auto raceId{reader.read<CMidgardID>()};
+    const auto nameId{reader.read<CMidgardID>()};
+    const auto level{reader.read<int>()};
+    const auto value{reader.read<int>()};
+    const auto unitType{static_cast<UnitType>(reader.read<int>())};
+    const auto subrace{
+        static_cast<SubRaceType>(readCachedEnum(reader, isKnownSubRaceType, "subrace"))};
+    const auto reach{static_cast<ReachType>(reader.read<int>())};
+    const auto attackType{static_cast<AttackType>(reader.read<int>())};
+    const auto hp{reader.read<int>()};
+    const auto move{reader.read<int>()};
+    const auto leadership{reader.read<int>()};
+    const auto big{reader.read<bool>()};
+    const auto male{reader.read<bool>()};
+
+    return std::make_unique<StandaloneUnitInfo>(unitId, raceId, nameId, level, value, unitType,
+                                                subrace, reach, attackType, hp, move, leadership,
+                                                big, male);
+}
+
+static void writeCachedSiteTexts(CacheWriter& writer, const SiteTexts& texts)
+{
+    writer.write(static_cast<std::uint32_t>(texts.size()));
+    for (const auto& text : texts) {
+        writer.write(text.name);
+        writer.write(text.description);
+    }
+}
+
+static void readCachedSiteTexts(CacheReader& reader, SiteTexts& texts)
+{
+    // Name and description start with their sizes
+    texts.resize(reader.readSize(2 * sizeof(std::uint32_t)));
+    for (auto& text : texts) {
+        reader.read(text.name);
+        reader.read(text.description);
+    }
+}
+
+void StandaloneGameInfo::writeCache(const std::filesystem::path& cacheFilePath,
+                                    std::uint64_t key) const
+{
+    CacheWriter writer;
+
+    // Settings go first, landmarks are sorted by race using them
+    writeGeneratorSettings(writer, getGeneratorSettings());
+
+    // Leaders and soldiers go first to keep their order
+    writer.write(static_cast<std::uint32_t>(unitsInfo.size()));
+    for (const auto* unit : leaders) {
+        writeCachedUnit(writer, *unit);
+    }
+
+    for (const auto* unit : soldiers) {
+        writeCachedUnit(writer, *unit);
+    }
+
+    for (const auto& [id, unit] : unitsInfo) {
+        const auto type{unit->getUnitType()};
+
+        if (type != UnitType::Leader && type != UnitType::Soldier) {
+            writeCachedUnit(writer, *unit);
+        }
+    }
+
+    writer.write(static_cast<std::uint32_t>(allItems.size()));
+    for (const auto* item : allItems) {
+        writer.write(item->getItemId());
+        writer.write(item->getValue());
+        writer.write(static_cast<int>(item->getItemType()));
+    }
+
+    writer.write(static_cast<std::uint32_t>(allSpells.size()));
+    for (const auto* spell : allSpells) {
+        writer.write(spell->getSpellId());
+        writer.write(spell->getValue());
+        writer.write(spell->getLevel());
+        writer.write(static_cast<int>(spell->getSpellType()));
+    }
+
+    writer.write(static_cast<std::uint32_t>(allLandmarks.size()));
+    for (const auto* landmark : allLandmarks) {
+        writer.write(landmark->getLandmarkId());
+        writer.write(landmark->getSize().x);
+        writer.write(landmark->getSize().y);
+        writer.write(static_cast<int>(landmark->getLandmarkType()));
+        writer.write(landmark->isMountain());
+    }
+
+    writer.write(static_cast<std::uint32_t>(racesInfo.size()));
+    for (const auto& [id, race] : racesInfo) {
+        writer.write(race->getRaceId());
+        writer.write(race->getGuardianUnitId());
+        writer.write(race->getNobleLeaderId());
+        writer.write(static_cast<int>(race->getRaceType()));
+        writer.write(race->getLeaderNames().maleNames);
+        writer.write(race->getLeaderNames().femaleNames);
+        writer.write(race->getLeaderIds());
+    }
+
+    writer.write(globalTexts);
+    writer.write(editorInterfaceTexts);
+
+    writer.write(cityNames);
+
+    writeCachedSiteTexts(writer, mercenaryTexts);
+    writeCachedSiteTexts(writer, mageTexts);
+    writeCachedSiteTexts(writer, merchantTexts);
+    writeCachedSiteTexts(writer, ruinTexts);
+    writeCachedSiteTexts(writer, trainerTexts);
+
+    writeGameInfoCache(cacheFilePath, key, writer);
+}
+
+bool StandaloneGameInfo::readCache(const std::filesystem::path& cacheFilePath, std::uint64_t key)
+{
+    auto cache{readGameInfoCache(cacheFilePath, key)};
+    if (!cache) {
+        return false;
+    }
+
+    unitsInfo.clear();
+    leaders.clear();
+    soldiers.clear();
+
+    minLeaderValue = std::numeric_limits<int>::max();
+    maxLeaderValue = std::numeric_limits<int>::min();
+
+    minSoldierValue = std::numeric_limits<int>::max();
+    maxSoldierValue = std::numeric_limits<int>::min();
+
+    itemsInfo.clear();
+    allItems.clear();
+    itemsByType.clear();
+
+    spellsInfo.clear();
+    allSpells.clear();
+    spellsByType.clear();
+
+    landmarksInfo.clear();
+    allLandmarks.clear();
+    landmarksByType.clear();
+    landmarksByRace.clear();
+    mountainLandmarks.clear();
+
+    racesInfo.clear();
+
+    try {
+        CacheReader reader{cache->contents, cache->contentsSize};
+
+        GeneratorSettings settings;
+        readGeneratorSettings(reader, settings);
+        setGeneratorSettings(std::move(settings));
+
+        const auto unitsTotal{reader.readSize()};
+        for (std::uint32_t i = 0; i < unitsTotal; ++i) {
+            addUnit(readCachedUnit(reader));
+        }
+
+        const auto itemsTotal{reader.readSize()};
+        for (std::uint32_t i = 0; i < itemsTotal; ++i) {
+            const auto itemId{reader.read<CMidgardID>()};
+            const auto value{reader.read<int>()};
+            const auto category{readCachedEnum(reader, isKnownItemType, "item category")};
+
+            addItem(std::make_unique<StandaloneItemInfo>(itemId, value,
+                                                         static_cast<ItemType>(category)));
+        }
+
+        const auto spellsTotal{reader.readSize()};
+        for (std::uint32_t i = 0; i < spellsTotal; ++i) {
+            const auto spellId{reader.read<CMidgardID>()};
+            const auto value{reader.read<int>()};
+            const auto level{reader.read<int>()};
+            const auto spellType{
+                static_cast<SpellType>(readCachedEnum(reader, isKnownSpellType, "spell type"))};
+
+            addSpell(std::make_unique<StandaloneSpellInfo>(spellId, value, level, spellType));
+        }
+
+        const auto landmarksTotal{reader.readSize()};
+        for (std::uint32_t i = 0; i < landmarksTotal; ++i) {
+            const auto landmarkId{reader.read<CMidgardID>()};
+            const auto x{reader.read<int>()};
+            const auto y{reader.read<int>()};
+            const auto landmarkType{static_cast<LandmarkType>(
+                readCachedEnum(reader, isKnownLandmarkType, "landmark type"))};
+            const auto mountain{reader.read<bool>()};
+
+            addLandmark(std::make_unique<StandaloneLandmarkInfo>(landmarkId, Position{x, y},
+                                                                 landmarkType, mountain));
+        }
+
+        const auto racesTotal{reader.readSize()};
+        for (std::uint32_t i = 0; i < racesTotal; ++i) {
+            const auto raceId{reader.read<CMidgardID>()};
+            const auto guardId{reader.read<CMidgardID>()};
+            const auto nobleId{reader.read<CMidgardID>()};
+            const auto raceType{
+                static_cast<RaceType>(readCachedEnum(reader, isKnownRaceType, "race type"))};
+
+            LeaderNames names;
+            reader.read(names.maleNames);
+            reader.read(names.femaleNames);
+
+            std::vector<CMidgardID> leaderIds;
+            reader.read(leaderIds);
+
+            racesInfo[raceId] = std::make_unique<StandaloneRaceInfo>(raceId, guardId, nobleId,
+                                                                     raceType, std::move(names),
+                                                                     std::move(leaderIds));
+        }
+
+        // Texts are used in place, mapping is kept while game info exists
+        reader.read(globalTexts);
+        reader.read(editorInterfaceTexts);
+
+        reader.read(cityNames);
+
+        readCachedSiteTexts(reader, mercenaryTexts);
+        readCachedSiteTexts(reader, mageTexts);
+        readCachedSiteTexts(reader, merchantTexts);
+        readCachedSiteTexts(reader, ruinTexts);
+        readCachedSiteTexts(reader, trainerTexts);
+
+        if (!reader.atEnd()) {
+            throw std::runtime_error("Game info cache has unexpected data");
+        }
+    } catch (const std::exception& e) {
+        // Everything is read from game files anew
+        std::cerr << "Could not read game info cache: " << e.what() << '\n';
+
+        globalTexts = TextTable{};
+        editorInterfaceTexts = TextTable{};
+        return false;
+    }
+
+    cacheFile = std::move(cache->file);
+    return true;
+}
+
 bool StandaloneGameInfo::readGameInfo(const std::filesystem::path& gameFolderPath)
 {
     const std::filesystem::path globalsFolder{gameFolderPath / "Globals"};
     const std::filesystem::path scenDataFolder{gameFolderPath / "ScenData"};
     const std::filesystem::path interfDataFolder{gameFolderPath / "Interf"};
 
-    return readGeneratorSettings(gameFolderPath) && readRacesInfo(globalsFolder)
-           && readUnitsInfo(globalsFolder) && readItemsInfo(globalsFolder)
-           && readSpellsInfo(globalsFolder) && readLandmarksInfo(globalsFolder)
-           && readGlobalTexts(globalsFolder) && readEditorInterfaceTexts(interfDataFolder)
-           && readCityNames(scenDataFolder) && readSiteTexts(scenDataFolder);
+    // Readers fill separate members so they can run concurrently.
+    // Landmarks are sorted by races using generator settings, read them after settings.
+    // Leader names and attacks are read by races and units readers themselves
+    const std::function<bool()> readers[] = {
+        [&]() { return readGeneratorSettings(gameFolderPath) && readLandmarksInfo(globalsFolder); },
+        [&]() { return readUnitsInfo(globalsFolder); },
+        [&]() { return readGlobalTexts(globalsFolder); },
+        [&]() { return readItemsInfo(globalsFolder); },
+        [&]() { return readSpellsInfo(globalsFolder); },
+        [&]() { return readRacesInfo(globalsFolder); },
+        [&]() { return readEditorInterfaceTexts(interfDataFolder); },
+        [&]() { return readCityNames(scenDataFolder); },
+        [&]() { return readSiteTexts(scenDataFolder); },
+    };
+
+    constexpr std::size_t readersTotal{std::size(readers)};
+
+    // Not std::vector<bool>, elements are written from different threads
+    std::vector<char> results(readersTotal);
+    std::vector<std::exception_ptr> errors(readersTotal);
+    std::atomic<std::size_t> nextReader{0};
+
+    auto worker = [&readers, &results, &errors, &nextReader]() {
+        for (auto index = nextReader++; index < readersTotal; index = nextReader++) {
+            try {
+                results[index] = readers[index]();
+            } catch (...) {
+                errors[index] = std::current_exception();
+            }
+        }
+    };
+
+    const std::size_t threadsTotal{
+        std::min<std::size_t>(readersTotal, std::max(1u, std::thread::hardware_concurrency()))};
+
+    // Current thread reads tables too
+    runInThreads(threadsTotal, worker);
+
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    return std::all_of(results.begin(), results.end(), [](char result) { return result != 0; });
 }
 
 } // namespace rsg
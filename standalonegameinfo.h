@@ -20,15 +20,29 @@
 #pragma once
 
 #include "gameinfo.h"
+#include "gameinfocache.h"
+#include "mappedfile.h"
+#include <cstdint>
 #include <filesystem>
+#include <memory>
 
 namespace rsg {
 
+class StandaloneUnitInfo;
+class StandaloneItemInfo;
+class StandaloneSpellInfo;
+class StandaloneLandmarkInfo;
+
 // Game interface for standalone generator builds
 class StandaloneGameInfo final : public GameInfo
 {
 public:
-    StandaloneGameInfo(const std::filesystem::path& gameFolderPath);
+    // If cache folder is specified, game info is restored from cache when game files
+    // were not changed since the cache was created. Otherwise cache is created anew.
+    // Folder is created if needed and must be owned by current user, others lose access to it.
+    // Caching is skipped if folder can not be used
+    StandaloneGameInfo(const std::filesystem::path& gameFolderPath,
+                       const std::filesystem::path& cacheFolder = {});
 
     ~StandaloneGameInfo() override = default;
 
@@ -89,6 +103,14 @@ public:
 private:
     bool readGameInfo(const std::filesystem::path& gameFolderPath);
 
+    bool readCache(const std::filesystem::path& cacheFilePath, std::uint64_t key);
+    void writeCache(const std::filesystem::path& cacheFilePath, std::uint64_t key) const;
+
+    void addUnit(std::unique_ptr<StandaloneUnitInfo>&& info);
+    void addItem(std::unique_ptr<StandaloneItemInfo>&& info);
+    void addSpell(std::unique_ptr<StandaloneSpellInfo>&& info);
+    void addLandmark(std::unique_ptr<StandaloneLandmarkInfo>&& info);
+
     bool readUnitsInfo(const std::filesystem::path& globalsFolderPath);
     bool readItemsInfo(const std::filesystem::path& globalsFolderPath);
     bool readSpellsInfo(const std::filesystem::path& globalsFolderPath);
@@ -101,7 +123,7 @@ private:
     bool readCityNames(const std::filesystem::path& scenDataFolderPath);
     bool readSiteTexts(const std::filesystem::path& scenDataFolderPath);
 
-    const char* getText(const TextsInfo& texts, const CMidgardID& textId) const;
+    const char* getText(const TextTable& texts, const CMidgardID& textId) const;
 
     UnitsInfo unitsInfo{};
     UnitInfoArray leaders{};
@@ -122,14 +144,17 @@ private:
     std::map<SpellType, SpellInfoArray> spellsByType;
 
     LandmarksInfo landmarksInfo;
+    LandmarkInfoArray allLandmarks; // In order of GLmark.dbf records
     std::map<LandmarkType, LandmarkInfoArray> landmarksByType;
     std::map<RaceType, LandmarkInfoArray> landmarksByRace;
     LandmarkInfoArray mountainLandmarks;
 
     RacesInfo racesInfo;
 
-    TextsInfo globalTexts;
-    TextsInfo editorInterfaceTexts;
+    // Texts read from cache refer to the mapped cache file
+    MappedFile cacheFile;
+    TextTable globalTexts;
+    TextTable editorInterfaceTexts;
 
     CityNames cityNames;
 